@@ -2,6 +2,7 @@
 #define TDL_INCLUDE_CODEGEN_ALIGNMENT_INFO_PASS_H
 
 #include <map>
+#include <utility>
 #include <vector>
 
 namespace triton {
@@ -70,6 +71,8 @@ private:
   std::map<ir::value*, std::vector<cst_info>> is_constant_;
   std::map<ir::value*, std::vector<unsigned>> max_contiguous_;
   std::map<ir::value*, std::vector<unsigned>> starting_multiple_;
+  // kind and operands of every instruction at the last run
+  std::map<ir::value*, std::pair<unsigned, std::vector<ir::value*>>> sigs_;
 };
 
 
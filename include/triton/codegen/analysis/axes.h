@@ -2,7 +2,7 @@
 #define _TRITON_CODEGEN_ANALYSIS_AXES_H_
 
 #include "triton/tools/graph.h"
-#include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace triton{
@@ -17,9 +17,10 @@ namespace codegen{
 namespace analysis{
 
 class axes {
-  typedef std::pair<ir::value*, unsigned> node_t;
-
 private:
+  // dense id of axis `dim` of `value`
+  size_t node(ir::value* value, unsigned dim);
+  void add_edge(ir::value* x, unsigned dx, ir::value* y, unsigned dy);
   // update graph
   void update_graph_store(ir::instruction *i);
   void update_graph_reduce(ir::instruction *i);
@@ -39,8 +40,12 @@ public:
   std::vector<int> get(ir::value *value);
 
 private:
-  tools::graph<node_t> graph_;
-  std::map<node_t, size_t> axes_;
+  tools::graph graph_;
+  // node ids of the axes of every value, assigned per module
+  std::unordered_map<ir::value*, std::vector<size_t>> nodes_;
+  size_t num_nodes_;
+  // axis of every node
+  tools::graph::nmap_t axes_;
 };
 
 }
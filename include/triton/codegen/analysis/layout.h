@@ -3,6 +3,7 @@
 
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 #include "triton/tools/graph.h"
@@ -179,11 +180,9 @@ private:
 
 
 class layouts {
-  typedef ir::value* node_t;
-  typedef std::map <node_t, std::set<node_t>> graph_t;
-
 private:
   // graph creation
+  size_t node(ir::value *v);
   void connect(ir::value *x, ir::value *y);
   void make_graph(ir::instruction *i);
 
@@ -213,7 +212,10 @@ private:
   analysis::align* align_;
   size_t num_warps_;
   target* tgt_;
-  tools::graph<ir::value*> graph_;
+  tools::graph graph_;
+  // node ids of values, assigned per module
+  std::unordered_map<ir::value*, size_t> nodes_;
+  std::vector<ir::value*> node_values_;
   std::map<ir::value*, size_t> groups_;
   std::map<size_t, std::vector<ir::value*>> values_;
   std::map<size_t, data_layout*> layouts_;
@@ -1,7 +1,11 @@
 #ifndef _TRITON_CODEGEN_PASS_H_
 #define _TRITON_CODEGEN_PASS_H_
 
-#include <list>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace triton{
 
@@ -11,20 +15,79 @@ namespace ir{
 
 namespace codegen{
 
-class pass {
-public:
-  virtual void run(ir::module& m);
+// statistics of one run of a pass
+struct pass_stat_t {
+  std::string name;
+  // steady clock, in microseconds
+  double start_us;
+  double time_us;
+  // triton-IR instructions before and after the pass
+  // (0 for steps that do not operate on triton-IR)
+  size_t num_insts_before;
+  size_t num_insts_after;
+};
+
+// step of a schedule
+struct pass_t {
+  enum kind_t { ANALYSIS, TRANSFORM };
+  kind_t kind;
+  std::string name;
+  std::function<void(ir::module&)> run;
+  // analyses: the analyses whose results this one is computed from
+  // transforms: the analyses whose results stay valid when this one changes the module
+  std::vector<std::string> deps;
+  // transforms: running this one on its own output changes nothing
+  bool idempotent;
 };
 
+typedef std::vector<pass_t> schedule_t;
+
+template<class P>
+pass_t make_analysis(const std::string& name, P& pass, const std::vector<std::string>& deps = {}) {
+  return {pass_t::ANALYSIS, name, [&pass](ir::module& m) { pass.run(m); }, deps, false};
+}
+
+template<class P>
+pass_t make_transform(const std::string& name, P& pass, const std::vector<std::string>& preserves = {}, bool idempotent = false) {
+  return {pass_t::TRANSFORM, name, [&pass](ir::module& m) { pass.run(m); }, preserves, idempotent};
+}
 
+// runs passes one after the other and times them
 class pass_manager {
 public:
-  void add(pass* p);
-  void run(ir::module& m);
+  // sums the sizes of the blocks of `m`
+  static size_t num_instructions(ir::module& m);
 
 private:
-  std::list<pass*> passes;
+  // number of instructions of `m`, counted again only when it changed
+  size_t count(ir::module& m);
+
+public:
+  // runs `fn` as the pass `name` on `m`
+  void run(const std::string& name, ir::module& m, const std::function<void()>& fn);
+  // runs `fn` as the step `name`, which does not work on triton-IR
+  void run(const std::string& name, const std::function<void()>& fn);
+  // runs the steps of `schedule` on `m`, except analyses that are still valid
+  // and idempotent transforms that would run on their own output
+  void run(const schedule_t& schedule, ir::module& m);
+  const std::vector<pass_stat_t>& stats() const { return stats_; }
+
+private:
+  std::vector<pass_stat_t> stats_;
+  // module counted last, and its version then
+  ir::module* counted_ = nullptr;
+  uint64_t counted_version_ = 0;
+  size_t count_ = 0;
 };
 
+// contents of a JSON string literal holding `str`
+std::string escape(const std::string& str);
+// [{"name": ..., "start_us": ..., "time_us": ..., "num_insts_before": ..., "num_insts_after": ...}, ...]
+std::string to_json(const std::vector<pass_stat_t>& stats);
+// document for chrome://tracing with one row per (label, stats) pair
+std::string to_chrome_trace(const std::vector<std::pair<std::string, std::vector<pass_stat_t>>>& rows);
+
 }
 }
+
+#endif
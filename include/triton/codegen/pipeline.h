@@ -0,0 +1,76 @@
+#ifndef _TRITON_CODEGEN_PIPELINE_H_
+#define _TRITON_CODEGEN_PIPELINE_H_
+
+#include <memory>
+#include "triton/codegen/pass.h"
+
+namespace llvm{
+  class Module;
+}
+
+namespace triton{
+
+namespace ir{
+  class module;
+}
+
+namespace codegen{
+
+class target;
+class generator;
+
+namespace analysis{
+class align;
+class axes;
+class layouts;
+class liveness;
+class swizzle;
+class allocation;
+}
+
+namespace transform{
+class cts;
+class disassociate;
+class membar;
+class dce;
+class peephole;
+class reassociate;
+class coalesce;
+}
+
+// Passes that lower triton-IR to LLVM-IR, and the schedule that runs them.
+// Shared by the runtime and by triton-cc, so that both compile kernels alike
+class pipeline {
+public:
+  pipeline(target* tgt, unsigned num_warps);
+  ~pipeline();
+  // optimizations, then the analyses needed by the generator
+  const schedule_t& schedule() const { return schedule_; }
+  // bytes of shared memory needed once the schedule has run
+  size_t allocated_size() const;
+  // steps that follow the schedule
+  void insert_barriers(ir::module& m);
+  void generate(ir::module& m, llvm::Module& llvm);
+
+private:
+  std::unique_ptr<analysis::align> align_;
+  std::unique_ptr<analysis::axes> axes_;
+  std::unique_ptr<analysis::layouts> layouts_;
+  std::unique_ptr<analysis::liveness> liveness_;
+  std::unique_ptr<analysis::swizzle> swizzle_;
+  std::unique_ptr<analysis::allocation> allocation_;
+  std::unique_ptr<transform::cts> cts_;
+  std::unique_ptr<transform::disassociate> disassociate_;
+  std::unique_ptr<transform::membar> barriers_;
+  std::unique_ptr<transform::dce> dce_;
+  std::unique_ptr<transform::peephole> peephole_;
+  std::unique_ptr<transform::reassociate> reassociate_;
+  std::unique_ptr<transform::coalesce> coalesce_;
+  std::unique_ptr<generator> isel_;
+  schedule_t schedule_;
+};
+
+}
+}
+
+#endif
@@ -6,6 +6,8 @@
 #include "triton/ir/visitor.h"
 #include "triton/codegen/analysis/layout.h"
 #include <functional>
+#include <memory>
+#include <unordered_map>
 
 // forward
 namespace llvm{
@@ -74,9 +76,49 @@ struct distributed_axis {
   Value* thread_id;
 };
 
+// indices of the elements of a tile, in storage order; shared by all
+// values with the same layout and the same dimension-to-axis mapping
+struct tile_idx_t {
+  std::vector<indices_t> idxs;
+  std::map<indices_t, size_t> pos;
+};
+
+// values of the elements of a tile, stored contiguously
+// in the order of their tile_idx_t (one element for scalars)
+class tile_vals_t {
+public:
+  static const tile_idx_t* scalar_idx();
+
+public:
+  tile_vals_t(): idx_(scalar_idx()), vals_(1) { }
+  // keeps the current values if the index does not change
+  void init(const tile_idx_t* idx) {
+    if(idx == idx_)
+      return;
+    idx_ = idx;
+    vals_.assign(idx->idxs.size(), nullptr);
+  }
+  const tile_idx_t* index() const { return idx_; }
+  size_t size() const { return vals_.size(); }
+  Value*& operator[](size_t i) { return vals_[i]; }
+  Value*& operator[](const indices_t& idx) { return vals_[idx_->pos.at(idx)]; }
+  // element of `idx` at position `i`; O(1) when `idx` is the index of these values
+  Value*& at(const tile_idx_t* idx, size_t i) { return idx == idx_ ? vals_[i] : (*this)[idx->idxs[i]]; }
+
+private:
+  const tile_idx_t* idx_;
+  std::vector<Value*> vals_;
+};
+
 class generator: public ir::visitor, public analysis::layout_visitor {
+private:
+  typedef std::function<Value*(const std::vector<Value*>&, size_t)> elementwise_fn_t;
+
 private:
   void init_idx(ir::value *x);
+  const std::vector<indices_t>& get_idxs(ir::value *x) { return vals_.at(x).index()->idxs; }
+  size_t vector_width(ir::value *x);
+  void visit_elementwise(ir::instruction *x, const elementwise_fn_t& fn);
   Instruction* add_barrier();
   Value* shared_off(const std::vector<unsigned>& shapes, const std::vector<int>& order, indices_t idx);
   void finalize_shared_layout(analysis::shared_layout*);
@@ -126,11 +168,13 @@ public:
   void visit_mma884(ir::dot_inst*, ir::value *A, ir::value *B, ir::value *D, unsigned NK);
   void visit_mma16816(ir::dot_inst*, ir::value *A, ir::value *B, ir::value *D, unsigned NK);
   void visit_fmadot(ir::dot_inst*, ir::value *A, ir::value *B, ir::value *D, unsigned NK, Type *c_ty, Function *f_mul_add);
+  void visit_cpudot(ir::dot_inst*, ir::value *A, ir::value *B, ir::value *D, unsigned NK, Type *c_ty);
   void visit_dot_inst(ir::dot_inst*);
   void visit_trans_inst(ir::trans_inst*);
   void visit_sqrt_inst(ir::sqrt_inst*);
   void visit_reduce1d_inst(ir::reduce_inst*, std::function<Value*(Value*,Value*)>, Value*);
   void visit_reducend_inst(ir::reduce_inst*, std::function<Value*(Value*,Value*)>, Value*);
+  void visit_reduce_cpu_inst(ir::reduce_inst*, std::function<Value*(Value*,Value*)>);
   void visit_reduce_inst(ir::reduce_inst*);
   void visit_select_inst(ir::select_inst*);
   void visit_recoalesce_inst(ir::recoalesce_inst*);
@@ -186,8 +230,9 @@ private:
 
   std::map<ir::value*, Value*> shmems_;
   std::map<ir::value*, Value*> shoffs_;
-  std::map<ir::value*, std::vector<indices_t>> idxs_;
-  std::map<ir::value*, std::map<indices_t, Value*>> vals_;
+  // tile indices, computed once per layout and dimension-to-axis mapping
+  std::map<std::pair<analysis::data_layout*, std::vector<int>>, std::unique_ptr<tile_idx_t>> tile_idxs_;
+  std::unordered_map<ir::value*, tile_vals_t> vals_;
   std::map<ir::value*, BasicBlock *> bbs_;
   std::map<ir::value*, std::vector<int>> ords_;
 
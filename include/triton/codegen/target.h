@@ -49,6 +49,8 @@ public:
   virtual Value* get_block_id(Module *module, Builder& builder, unsigned ax) = 0;
   virtual Value* get_num_blocks(Module *module, Builder& builder, unsigned ax) = 0;
   virtual unsigned guaranteed_alignment() = 0;
+  // widest vector load/store, in bits
+  virtual unsigned vector_bits() const { return 128; }
   nvidia_cu_target* as_nvidia();
   bool is_gpu() const;
 
@@ -88,7 +90,7 @@ private:
 
 class cpu_target: public target {
 public:
-  cpu_target(): target(false){}
+  cpu_target(unsigned vector_bits = 128): target(false), vector_bits_(vector_bits){}
   void set_kernel(Builder& builder, LLVMContext &ctx, Module *module, Function* fn);
   Instruction* add_barrier(Module *module, Builder& builder);
   Instruction* add_memfence(Module *module, Builder& builder);
@@ -97,6 +99,10 @@ public:
   Value* get_block_id(Module *module, Builder& builder, unsigned ax);
   Value* get_num_blocks(Module *module, Builder& builder, unsigned ax);
   unsigned guaranteed_alignment() { return 1; }
+  unsigned vector_bits() const { return vector_bits_; }
+
+private:
+  unsigned vector_bits_;
 };
 
 }
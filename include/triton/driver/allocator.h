@@ -0,0 +1,116 @@
+#pragma once
+
+#ifndef _TRITON_DRIVER_ALLOCATOR_H_
+#define _TRITON_DRIVER_ALLOCATOR_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "triton/driver/handle.h"
+
+namespace triton
+{
+namespace driver
+{
+
+class stream;
+
+// Base
+class allocator {
+public:
+  struct stats_t {
+    // bytes currently handed out to buffers
+    size_t in_use = 0;
+    // bytes released by buffers but kept for reuse
+    size_t cached = 0;
+    // peak of in_use + cached
+    size_t high_watermark = 0;
+    // number of allocations, and how many of them were served from cache
+    size_t num_allocs = 0;
+    size_t num_hits = 0;
+  };
+
+protected:
+  uintptr_t raw_allocate(size_t size, driver::stream* stream);
+  void raw_release(uintptr_t ptr, size_t size);
+
+public:
+  allocator(backend_t backend): backend_(backend) { }
+  virtual ~allocator() { }
+  // memory returned by `allocate(size, stream)` may only be
+  // used by work submitted to `stream` (any stream if null)
+  virtual uintptr_t allocate(size_t size, driver::stream* stream) = 0;
+  virtual void release(uintptr_t ptr, size_t size, driver::stream* stream) = 0;
+  // returns cached memory to the backend
+  virtual void trim() { }
+  virtual stats_t stats() = 0;
+  backend_t backend() const { return backend_; }
+  // allocator used by host and CUDA buffers
+  static std::shared_ptr<allocator> get(backend_t backend);
+  static void set(backend_t backend, std::shared_ptr<allocator> alloc);
+  // called by streams when they are destroyed, so that no allocator
+  // keeps memory cached on them
+  static void forget(driver::stream* stream);
+
+protected:
+  backend_t backend_;
+};
+
+// One backend allocation per buffer
+class direct_allocator: public allocator {
+public:
+  direct_allocator(backend_t backend): allocator(backend) { }
+  uintptr_t allocate(size_t size, driver::stream* stream);
+  void release(uintptr_t ptr, size_t size, driver::stream* stream);
+  stats_t stats();
+
+private:
+  std::mutex mutex_;
+  stats_t stats_;
+};
+
+// Released blocks are binned by size class and by the stream they were
+// used on. A block is reused right away by the same stream, since later
+// work on that stream is ordered after earlier work. Host blocks released
+// without a stream can be reused by any stream. CUDA blocks released
+// without a stream may still be in use on any stream: they are reused
+// only after the context is synchronized, as cuMemFree would have done.
+// Blocks cached on a stream that is destroyed are handled like blocks
+// released without a stream.
+class caching_allocator: public allocator {
+  typedef std::pair<driver::stream*, size_t> bin_key_t;
+
+public:
+  // rounds up to one of four classes per power of two (at most 25% waste)
+  static size_t size_class(size_t size);
+
+public:
+  caching_allocator(backend_t backend);
+  ~caching_allocator();
+  uintptr_t allocate(size_t size, driver::stream* stream);
+  void release(uintptr_t ptr, size_t size, driver::stream* stream);
+  void trim();
+  stats_t stats();
+  // moves the blocks cached on `stream` out of its bins
+  void forget_stream(driver::stream* stream);
+
+private:
+  bool pop(const bin_key_t& key, uintptr_t& ptr);
+  // makes CUDA blocks released without a stream reusable by all streams
+  void synchronize_unordered();
+
+private:
+  std::mutex mutex_;
+  // held while trim() synchronizes streams, which are then not destroyed
+  std::mutex trim_mutex_;
+  std::map<bin_key_t, std::vector<uintptr_t>> bins_;
+  // CUDA blocks released without a stream, by size class
+  std::map<size_t, std::vector<uintptr_t>> unordered_;
+  stats_t stats_;
+};
+
+}
+}
+
+#endif
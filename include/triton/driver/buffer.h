@@ -5,6 +5,7 @@
 
 #include "triton/driver/handle.h"
 #include "triton/driver/context.h"
+#include "triton/driver/allocator.h"
 
 namespace triton
 {
@@ -18,26 +19,34 @@ class buffer : public polymorphic_resource<CUdeviceptr, host_buffer_t> {
 public:
   buffer(size_t size, CUdeviceptr cl, bool take_ownership);
   buffer(size_t size, host_buffer_t hst, bool take_ownership);
+  ~buffer();
   uintptr_t addr_as_uintptr_t();
-  static buffer* create(driver::context* ctx, size_t size);
+  // memory comes from `allocator::get(ctx->backend())`; buffers created on
+  // a stream may only be used by work submitted to that stream
+  static buffer* create(driver::context* ctx, size_t size, driver::stream* stream = nullptr);
   size_t size();
 
+protected:
+  void allocate(backend_t backend, driver::stream* stream);
+
 protected:
   size_t size_;
+  std::shared_ptr<driver::allocator> alloc_;
+  driver::stream* stream_;
 };
 
 // CPU
 class host_buffer: public buffer
 {
 public:
-  host_buffer(size_t size);
+  host_buffer(size_t size, driver::stream* stream = nullptr);
 };
 
 // CUDA
 class cu_buffer: public buffer
 {
 public:
-  cu_buffer(size_t size);
+  cu_buffer(size_t size, driver::stream* stream = nullptr);
   cu_buffer(size_t size, CUdeviceptr cu, bool take_ownership);
   void set_zero(triton::driver::stream *queue, size_t size);
 };
@@ -67,6 +67,7 @@ public:
   static CUresult cuCtxGetCurrent(CUcontext *pctx);
   static CUresult cuCtxSetCurrent(CUcontext ctx);
   static CUresult cuCtxDestroy_v2(CUcontext ctx);
+  static CUresult cuCtxSynchronize();
   static CUresult cuEventCreate(CUevent *phEvent, unsigned int Flags);
   static CUresult cuDeviceGet(CUdevice *device, int ordinal);
   static CUresult cuMemcpyDtoH_v2(void *dstHost, CUdeviceptr srcDevice, size_t ByteCount);
@@ -88,11 +89,14 @@ public:
   static CUresult cuMemcpyHtoD_v2(CUdeviceptr dstDevice, const void *srcHost, size_t ByteCount);
   static CUresult cuInit(unsigned int Flags);
   static CUresult cuEventRecord(CUevent hEvent, CUstream hStream);
+  static CUresult cuEventQuery(CUevent hEvent);
+  static CUresult cuEventSynchronize(CUevent hEvent);
   static CUresult cuCtxCreate_v2(CUcontext *pctx, unsigned int flags, CUdevice dev);
   static CUresult cuCtxPushCurrent_v2(CUcontext ctx);
   static CUresult cuCtxPopCurrent_v2(CUcontext *pctx);
   static CUresult cuModuleGetFunction(CUfunction *hfunc, CUmodule hmod, const char *name);
   static CUresult cuStreamSynchronize(CUstream hStream);
+  static CUresult cuStreamWaitEvent(CUstream hStream, CUevent hEvent, unsigned int Flags);
   static CUresult cuStreamGetCtx(CUstream hStream, CUcontext* pctx);
   static CUresult cuStreamDestroy_v2(CUstream hStream);
   static CUresult cuEventDestroy_v2(CUevent hEvent);
@@ -130,6 +134,7 @@ private:
   static void* cuCtxGetCurrent_;
   static void* cuCtxSetCurrent_;
   static void* cuCtxDestroy_v2_;
+  static void* cuCtxSynchronize_;
   static void* cuEventCreate_;
   static void* cuDeviceGet_;
   static void* cuMemcpyDtoH_v2_;
@@ -151,9 +156,12 @@ private:
   static void* cuMemcpyHtoD_v2_;
   static void* cuInit_;
   static void* cuEventRecord_;
+  static void* cuEventQuery_;
+  static void* cuEventSynchronize_;
   static void* cuCtxCreate_v2_;
   static void* cuModuleGetFunction_;
   static void* cuStreamSynchronize_;
+  static void* cuStreamWaitEvent_;
   static void* cuStreamDestroy_v2_;
   static void* cuStreamGetCtx_;
   static void* cuEventDestroy_v2_;
@@ -0,0 +1,57 @@
+#pragma once
+
+#ifndef _TRITON_DRIVER_EVENT_H_
+#define _TRITON_DRIVER_EVENT_H_
+
+#include "triton/driver/handle.h"
+
+namespace triton
+{
+
+namespace driver
+{
+
+class stream;
+
+// Base
+class event: public polymorphic_resource<CUevent, host_event_t> {
+public:
+  event(CUevent, bool has_ownership);
+  event(host_event_t, bool has_ownership);
+  // factory
+  static driver::event* create(backend_t backend);
+  // methods
+  // completes once all the work submitted to `stream` so far is done
+  virtual void record(driver::stream* stream) = 0;
+  // whether the last record completed
+  virtual bool query() = 0;
+  virtual void synchronize() = 0;
+  // milliseconds between the completions of the last records of `start` and of this event
+  virtual float elapsed_time(driver::event* start) = 0;
+};
+
+// Host
+class host_event: public event {
+public:
+  host_event();
+  void record(driver::stream* stream);
+  bool query();
+  void synchronize();
+  float elapsed_time(driver::event* start);
+};
+
+// CUDA
+class cu_event: public event {
+public:
+  cu_event();
+  void record(driver::stream* stream);
+  bool query();
+  void synchronize();
+  float elapsed_time(driver::event* start);
+};
+
+}
+
+}
+
+#endif
@@ -3,26 +3,25 @@
 #ifndef _TRITON_DRIVER_HANDLE_H_
 #define _TRITON_DRIVER_HANDLE_H_
 
+#include <chrono>
 #include <memory>
 #include <map>
+#include <set>
+#include <vector>
 #include <iostream>
 #include <functional>
 #include <type_traits>
 #include "triton/driver/dispatch.h"
-#include "llvm/ExecutionEngine/JITSymbol.h"
-#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
-#include "llvm/ExecutionEngine/Orc/Core.h"
-#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
-#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
-#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
-#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
-#include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "triton/tools/thread_pool.h"
+#include "triton/tools/work_stealing_pool.h"
 
 namespace llvm
 {
-class ExecutionEngine;
 class Function;
+namespace orc
+{
+class JITDylib;
+}
 }
 
 namespace triton
@@ -49,28 +48,61 @@ struct host_context_t{
 
 };
 
+// launches of a host stream run one after the other;
+// the next one is started when the current one retires
+struct host_stream_queue_t{
+  typedef std::function<void(tools::work_stealing_pool::done_fn_t)> start_fn_t;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<start_fn_t> pending;
+  bool busy = false;
+};
+
+// completion of the work submitted to host streams before each record
+struct host_event_state_t{
+  std::mutex mutex;
+  std::condition_variable cv;
+  // number of records. records on different streams retire out of
+  // order: all of those up to `completed` did, and so did `retired`
+  uint64_t recorded = 0;
+  uint64_t completed = 0;
+  std::set<uint64_t> retired;
+  // when the latest record retired
+  std::chrono::steady_clock::time_point time;
+  // jobs waiting for a record to complete, keyed by record
+  std::multimap<uint64_t, std::function<void()>> waiters;
+
+  bool has_retired(uint64_t id) const { return id <= completed || retired.count(id); }
+};
+
+struct host_event_t{
+  std::shared_ptr<host_event_state_t> state;
+};
+
+class host_graph;
+
 struct host_stream_t{
-  std::shared_ptr<ThreadPool> pool;
-  std::shared_ptr<std::vector<std::future<void>>> futures;
-  std::vector<std::shared_ptr<char*>> args;
+  std::shared_ptr<tools::work_stealing_pool> pool;
+  std::shared_ptr<host_stream_queue_t> queue;
+  // launches are recorded into this graph rather than run
+  host_graph* capture = nullptr;
 };
 
+// object code of a host module lives in its own dylib
+// of the process-wide JIT session
 struct host_module_t{
-  std::string error;
-  llvm::ExecutionEngine* engine;
-  std::map<std::string, llvm::Function*> functions;
-  void(*fn)(char**, int32_t, int32_t, int32_t);
-  llvm::orc::ExecutionSession* ES;
-  llvm::orc::RTDyldObjectLinkingLayer* ObjectLayer;
-  llvm::orc::IRCompileLayer* CompileLayer;
-  llvm::DataLayout* DL;
-  llvm::orc::MangleAndInterner* Mangle;
-  llvm::orc::ThreadSafeContext* Ctx;
-  llvm::orc::JITDylib *MainJD;
+  llvm::orc::JITDylib* dylib;
+  // shared library compiled ahead of time by triton-cc (dlopen handle)
+  void* lib;
+  // (args, program ids, grid size)
+  void(*fn)(char**, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t);
 };
 
 struct host_function_t{
-  llvm::Function* fn;
+  void* fn;
+  // offsets of the pointer arguments in the argument buffer;
+  // launches of a host graph that share none are independent
+  std::vector<size_t> ptr_offsets;
 };
 
 struct host_buffer_t{
@@ -27,7 +27,7 @@ class cu_device;
 // Base
 class module: public polymorphic_resource<CUmodule, host_module_t> {
 protected:
-  void init_llvm();
+  static void init_llvm();
 
   enum file_type_t{
     Object,
@@ -38,12 +38,15 @@ public:
   module(CUmodule mod, bool has_ownership);
   module(host_module_t mod, bool has_ownership);
   static module* create(driver::device* device, std::unique_ptr<llvm::Module> src);
-  void compile_llvm_module(std::unique_ptr<llvm::Module> module, const std::string& triple,
+  static module* create(driver::device* device, const std::string& binary);
+  static void compile_llvm_module(std::unique_ptr<llvm::Module> module, const std::string& triple,
                            const std::string &proc, std::string layout,
                            llvm::SmallVectorImpl<char> &buffer,
                            const std::string &features,
                            file_type_t file_type);
   virtual std::unique_ptr<buffer> symbol(const char * name) const = 0;
+  // serialized form accepted by `create(device, binary)`
+  virtual const std::string& binary() const = 0;
   std::string llir() const { return llir_; }
   int spilled() const { return spilled_; }
 
@@ -55,9 +58,28 @@ protected:
 
 // CPU
 class host_module: public module{
+  void load(const std::string& obj);
+
+public:
+  // adds the entry point `name(args, program ids, grid size)`, which
+  // unpacks the arguments and calls the first function of `module`
+  static void add_entry_point(llvm::Module& module, const std::string& name);
+  // relocatable object code for `cpu` and `features` (the host CPU if empty)
+  static std::string compile_llvm_module(std::unique_ptr<llvm::Module> module,
+                                         const std::string& cpu = "", const std::string& features = "");
+
 public:
   host_module(std::unique_ptr<llvm::Module> module);
+  host_module(const std::string& obj);
+  // entry point `entry` of a shared library opened with dlopen
+  host_module(void* lib, const std::string& entry);
   std::unique_ptr<buffer> symbol(const char * name) const;
+  void* address(const std::string& name) const;
+  const std::string& obj() const { return obj_; }
+  const std::string& binary() const { return obj_; }
+
+private:
+  std::string obj_;
 };
 
 // CUDA
@@ -69,6 +91,7 @@ public:
   cu_module(driver::device* device, const std::string& source);
   std::unique_ptr<buffer> symbol(const char * name) const;
   const std::string& ptx() const { return ptx_; }
+  const std::string& binary() const { return ptx_; }
 
 private:
   std::string ptx_;
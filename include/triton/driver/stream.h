@@ -3,7 +3,9 @@
 #ifndef _TRITON_DRIVER_STREAM_H_
 #define _TRITON_DRIVER_STREAM_H_
 
+#include <array>
 #include <map>
+#include <vector>
 #include "triton/driver/context.h"
 #include "triton/driver/device.h"
 #include "triton/driver/handle.h"
@@ -29,6 +31,8 @@ public:
   static driver::stream* create(backend_t backend);
   // methods
   virtual void synchronize() = 0;
+  // work submitted from now on starts once the last record of `event` completed
+  virtual void wait(driver::event* event) = 0;
   virtual void enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args = NULL, size_t args_size = 0) = 0;
   virtual void write(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void const* ptr) = 0;
   virtual void read(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void* ptr) = 0;
@@ -40,13 +44,81 @@ public:
 };
 
 // Host
+// Sequence of launches recorded by host_stream::begin_capture.
+// Arguments are kept by value. Launches that point into the same
+// allocation (see add_allocation) run in order, and the others
+// concurrently. Kernels whose pointer arguments are unknown
+// (host_function_t::ptr_offsets is empty) are ordered with every launch.
+// Exposed to python as triton.graph
+class host_graph {
+  friend class host_stream;
+
+public:
+  typedef void(*fn_t)(char**, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t);
+
+private:
+  struct node_t {
+    fn_t fn;
+    std::array<size_t, 3> grid;
+    size_t grain;
+    std::vector<char> params;
+    std::vector<size_t> ptr_offsets;
+    std::vector<size_t> succs;
+    size_t num_preds;
+  };
+
+  struct replay_t;
+
+  void add(node_t node);
+  const void* allocation_of(const void* ptr) const;
+  void link();
+  void run(tools::work_stealing_pool* pool, std::shared_ptr<replay_t> replay, size_t i);
+  void replay(tools::work_stealing_pool* pool, tools::work_stealing_pool::done_fn_t done);
+
+public:
+  // declares [base, base + size) as one allocation. Launches whose pointers
+  // all fall into declared allocations only wait for the launches that used
+  // the same allocations; any other launch is ordered with all launches
+  void add_allocation(const void* base, size_t size);
+  // replaces the pointer argument `from` by `to` in every launch
+  void rebind(const void* from, const void* to);
+  size_t num_launches() const { return nodes_.size(); }
+  // launches that wait for launch `i`, once captured
+  const std::vector<size_t>& successors(size_t i) const { return nodes_.at(i).succs; }
+
+private:
+  std::vector<node_t> nodes_;
+  std::vector<size_t> roots_;
+  std::map<const void*, size_t> allocations_;
+};
+
+// All host streams share one process-wide pool of workers
 class host_stream: public stream {
+  friend class host_event;
+  typedef std::function<void(tools::work_stealing_pool::done_fn_t)> start_fn_t;
+  void submit(start_fn_t start);
+  void submit(size_t n, size_t grain, tools::work_stealing_pool::range_fn_t fn);
+  size_t grain(size_t n);
+  void copy(char* dst, const char* src, size_t size, bool blocking);
+
 public:
   host_stream();
+  // waits for the work submitted so far
+  ~host_stream();
   void synchronize();
+  void wait(driver::event* event);
   void enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size);
+  // launches are recorded into `graph` until end_capture, instead of being run;
+  // nothing else may be submitted to the stream in the meantime
+  void begin_capture(host_graph* graph);
+  void end_capture();
+  // replays `graph` in stream order; the graph must not
+  // be modified until the stream is synchronized
+  void launch(host_graph* graph);
   void write(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void const* ptr);
   void read(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void* ptr);
+  // touches every page of [ptr, ptr + size) from the workers, split like a launch
+  void first_touch(char* ptr, size_t size, size_t page_size);
 };
 
 // CUDA
@@ -54,7 +126,9 @@ class cu_stream: public stream {
 public:
   cu_stream(CUstream str, bool take_ownership);
   cu_stream();
+  ~cu_stream();
   void synchronize();
+  void wait(driver::event* event);
   void enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size);
   void write(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void const* ptr);
   void read(driver::buffer* buf, bool blocking, std::size_t offset, std::size_t size, void* ptr);
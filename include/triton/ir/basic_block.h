@@ -39,7 +39,10 @@ public:
 
   // get instruction list
   inst_list_t           &get_inst_list()       { return inst_list_; }
-  void  erase(instruction *i)                  {  inst_list_.remove(i); }
+  void  erase(instruction *i)                  {  inst_list_.remove(i); bump_version(); }
+
+  // bumps the version of the module of this block, if any
+  void bump_version();
 
   // instruction iterator functions
   inline iterator                begin()       { return inst_list_.begin(); }
@@ -52,6 +52,7 @@ public:
   InstTy* insert(InstTy *inst, const std::string &name = ""){
     assert(block_);
     block_->get_inst_list().insert(insert_point_, inst);
+    block_->bump_version();
     inst->set_parent(block_);
     inst->set_name(name);
 //    for(ir::value* op: inst->ops())
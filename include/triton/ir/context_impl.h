@@ -3,8 +3,9 @@
 #ifndef _TRITON_IR_CONTEXT_IMPL_H_
 #define _TRITON_IR_CONTEXT_IMPL_H_
 
-#include <map>
+#include <unordered_map>
 #include "triton/ir/type.h"
+#include "triton/tools/arena.h"
 
 namespace triton{
 namespace ir{
@@ -14,6 +15,33 @@ class constant;
 class constant_int;
 class constant_fp;
 class undef_value;
+class make_range;
+class make_range_sta;
+
+/* Interning keys */
+struct pair_hash {
+  template<class T>
+  static void combine(size_t& seed, const T& x) {
+    seed ^= std::hash<T>()(x) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+
+  template<class T, class U>
+  size_t operator()(const std::pair<T, U>& x) const {
+    size_t seed = 0;
+    combine(seed, x.first);
+    combine(seed, x.second);
+    return seed;
+  }
+
+  template<class T>
+  size_t operator()(const std::pair<T, type::tile_shapes_t>& x) const {
+    size_t seed = 0;
+    combine(seed, x.first);
+    for(unsigned s: x.second)
+      combine(seed, s);
+    return seed;
+  }
+};
 
 /* Context impl */
 class context_impl {
@@ -22,19 +50,24 @@ public:
   context_impl(context &ctx);
 
 public:
+  // owns every type and value of the context;
+  // declared first so that it is destroyed last
+  tools::arena arena;
   // primitive types
   type void_ty, label_ty, half_ty, float_ty, double_ty;
   // derived types
   integer_type int1_ty, int8_ty, int16_ty, int32_ty, int64_ty, int128_ty;
   // Pointer types
-  std::map<std::pair<type*, unsigned>, pointer_type*> ptr_tys;
-  std::map<std::pair<type*, type::tile_shapes_t>, tile_type*> tile_tys;
+  std::unordered_map<std::pair<type*, unsigned>, pointer_type*, pair_hash> ptr_tys;
+  std::unordered_map<std::pair<type*, type::tile_shapes_t>, tile_type*, pair_hash> tile_tys;
   // Int constants
-  std::map<std::pair<type*, uint64_t>, constant_int*> int_constants_;
+  std::unordered_map<std::pair<type*, uint64_t>, constant_int*, pair_hash> int_constants_;
   // Float constants
-  std::map<std::pair<type*, double>, constant_fp*> fp_constants_;
+  std::unordered_map<std::pair<type*, double>, constant_fp*, pair_hash> fp_constants_;
   // undef values
-  std::map<type*, undef_value*> uv_constants_;
+  std::unordered_map<type*, undef_value*> uv_constants_;
+  // static ranges
+  std::unordered_map<make_range*, make_range_sta*> mr_sta_constants_;
 };
 
 }
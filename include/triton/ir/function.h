@@ -5,6 +5,7 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include "value.h"
 #include "constant.h"
 
@@ -104,6 +105,7 @@ public:
   // accessors
   const args_t &args() { return args_; }
   function_type* get_fn_type() { return fn_ty_; }
+  module* get_parent() { return parent_; }
 
   // factory methods
   static function *create(function_type *ty, linkage_types_t linkage,
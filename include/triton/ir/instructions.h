@@ -13,7 +13,7 @@
 #include "triton/ir/visitor.h"
 
 #define _TRITON_DEFINE_CLONE(name) \
-  ir::instruction* clone_impl() const { return new name(*this); }
+  ir::instruction* clone_impl() const { return new(get_type()->get_context()) name(*this); }
 
 #define _TRITON_DEFINE_ACCEPT(name) \
   void accept(visitor* v) { v->visit_ ## name (this); }
@@ -67,12 +67,15 @@ public:
 //    for(auto it = op_begin(); it != op_end(); it++)
 //      (*it)->add_use(res);
     res->parent_ = nullptr;
-    res->users_.clear();
+    res->clear_users();
     return res;
   }
   // instruction id
   value_id_t get_id() const { return id_; }
 
+protected:
+  void operands_changed();
+
 private:
   basic_block *parent_;
   std::map<ir::metadata::kind_t, unsigned> metadatas_;
@@ -98,7 +101,7 @@ public:
   void add_incoming(value *v, basic_block *block);
 
   // Type
-  void set_type(type *ty) { ty_ = ty; }
+  void set_type(type *ty) { ty_ = ty; operands_changed(); }
 
   // Factory methods
   static phi_node* create(type *ty, unsigned num_reserved, const std::string &name = "", instruction *next = nullptr);
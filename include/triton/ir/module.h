@@ -3,6 +3,7 @@
 #ifndef _TRITON_IR_MODULE_H_
 #define _TRITON_IR_MODULE_H_
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <stack>
@@ -91,6 +92,10 @@ public:
   const std::map<std::string, ir::value*>& globals() const    { return globals_; }
   // Metadata
   void add_metadata(const std::string &name, md_pair_t x)     { metadatas_[name] = x; }
+  // Version -- incremented whenever an instruction is inserted, erased or
+  // gets a new operand, so that passes can tell whether the module changed
+  uint64_t get_version() const                                { return version_; }
+  void bump_version()                                         { version_++; }
 
 private:
   std::string name_;
@@ -109,6 +114,7 @@ private:
   std::vector<ir::alloc_const*> allocs_;
   std::map<std::string, ir::value*> globals_;
   std::map<std::string, md_pair_t> metadatas_;
+  uint64_t version_ = 0;
 };
 
 }
@@ -47,6 +47,10 @@ public:
   };
 
 public:
+  // derived types are allocated in the arena of their context
+  static void* operator new(size_t size, context& ctx);
+  static void operator delete(void* ptr, context& ctx);
+  static void operator delete(void*) { }
   //constructors
   type(context &ctx, id_t id) : ctx_(ctx), id_(id) { }
 
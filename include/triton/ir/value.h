@@ -3,13 +3,15 @@
 #ifndef _TRITON_IR_VALUE_H_
 #define _TRITON_IR_VALUE_H_
 
+#include <cstddef>
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include <set>
 
 namespace triton{
 namespace ir{
 
+class context;
 class type;
 class use;
 class user;
@@ -21,16 +23,22 @@ class visitor;
 
 class value {
 public:
-  typedef std::set<user*> users_t;
+  // each user appears once, in no particular order
+  typedef std::vector<user*> users_t;
 
 public:
+  // values are allocated in the arena of their context,
+  // and destroyed all at once with it
+  static void* operator new(size_t size, context& ctx);
+  static void operator delete(void* ptr, context& ctx);
+  static void operator delete(void*) { }
   // constructor
   value(type *ty, const std::string &name = "");
   virtual ~value(){ }
   // uses
   void add_use(user* arg);
   users_t::iterator erase_use(user* arg);
-  const std::set<user*> &get_users() { return users_; }
+  const users_t &get_users() { return users_; }
   void replace_all_uses_with(value *target);
   // name
   void set_name(const std::string &name);
@@ -42,9 +50,16 @@ public:
 private:
   std::string name_;
 
+protected:
+  void clear_users() { users_.clear(); user_pos_.clear(); }
+
 protected:
   type *ty_;
   users_t users_;
+
+private:
+  // position of each user in users_, built once a value has many users
+  std::unordered_map<user*, size_t> user_pos_;
 };
 
 //===----------------------------------------------------------------------===//
@@ -58,6 +73,8 @@ public:
   typedef ops_t::const_iterator const_op_iterator;
 
 protected:
+  // called when operands are set or replaced
+  virtual void operands_changed() { }
   void resize_ops(unsigned num_ops) { ops_.resize(num_ops + num_hidden_); num_ops_ = num_ops; }
   void resize_hidden(unsigned num_hidden) { ops_.resize(num_ops_ + num_hidden); num_hidden_ = num_hidden; }
 
@@ -10,6 +10,7 @@
 #include <map>
 #include <set>
 #include <stack>
+#include <stdexcept>
 #include <string>
 
 class Macro;
@@ -50,6 +51,15 @@ private:
 };
 
 
+// Thrown when a symbolic macro is used in a way that needs its value:
+// in a conditional directive, as an operand of # or ##, or in #define/#undef
+class SymbolicMacroError: public std::runtime_error {
+public:
+  SymbolicMacroError(const std::string& name)
+    : std::runtime_error("symbolic macro '" + name + "' cannot be expanded lazily") {}
+};
+
+
 struct CondDirective {
   int tag_;
   bool enabled_;
@@ -135,6 +145,22 @@ public:
                           bool next,
                           const std::string& curPath);
 
+  // `name` is left unexpanded, so that the output can be
+  // specialized for several values of it
+  void AddSymbol(const std::string& name) { symbols_.insert(name); }
+  bool IsSymbol(const std::string& name) const {
+    return symbols_.find(name) != symbols_.end();
+  }
+  void CheckSymbol(const Token* tok) const {
+    if (tok->tag_ == Token::IDENTIFIER && IsSymbol(tok->str_))
+      throw SymbolicMacroError(tok->str_);
+  }
+  // Copies the output of Process() into os, replacing symbolic
+  // macros by their value; values are plain token sequences
+  // and must not contain identifiers
+  static void Specialize(TokenSequence& os, TokenSequence is,
+                         const std::map<std::string, const std::string*>& values);
+
   void AddSearchPath(std::string path);
   void HandleTheFileMacro(TokenSequence& os, const Token* macro);
   void HandleTheLineMacro(TokenSequence& os, const Token* macro);
@@ -156,6 +182,7 @@ private:
   bool curCond_;
 
   MacroMap macroMap_;
+  std::set<std::string> symbols_;
   PathList searchPaths_;
   const std::string* fName_;
   const std::string* fSrc_;
@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef _TRITON_RUNTIME_BUNDLE_H_
+#define _TRITON_RUNTIME_BUNDLE_H_
+
+#include <string>
+#include <vector>
+#include "triton/runtime/arg.h"
+#include "triton/runtime/function.h"
+
+namespace triton{
+namespace runtime{
+
+// Kernels compiled ahead of time by triton-cc into a shared library.
+// The description below is stored in the library as the
+// null-terminated string `<name>_bundle`
+struct bundle_t {
+  struct config_t {
+    // exported entry point (args, program ids, grid size)
+    std::string entry;
+    options_t opt;
+  };
+
+  // symbol of the description of the bundle `name`
+  static std::string symbol(const std::string& name) { return name + "_bundle"; }
+  // one line per field, tab-separated:
+  //   <name>
+  //   <arg_type>...
+  //   <argument name>...
+  //   <entry> <num_warps> <define>=<value>...   (once per configuration)
+  std::string to_str() const;
+  static bundle_t parse(const std::string& str);
+
+  std::string name;
+  std::vector<arg_type> sig;
+  std::vector<std::string> arg_names;
+  std::vector<config_t> configs;
+};
+
+}
+}
+
+#endif
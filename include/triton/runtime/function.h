@@ -12,6 +12,7 @@
 #include <functional>
 // codegen
 #include "triton/ir/context.h"
+#include "triton/codegen/pass.h"
 #include "triton/runtime/arg.h"
 #include "triton/runtime/error.h"
 
@@ -25,6 +26,8 @@ namespace driver{
   class device;
 }
 }
+// lang forward declaration
+class TokenSequence;
 // ir forward declaration
 namespace triton{
 namespace ir {
@@ -54,10 +57,17 @@ enum asm_mode_t {
   ASM_NV_SASS
 };
 
+// how integer arguments are mapped to auto-tuning cache keys
+enum autotune_bucket_t {
+  BUCKET_EXACT,
+  BUCKET_POW2
+};
+
 struct options_space_t {
   typedef std::pair<std::string, std::vector<std::string>> define_t;
   std::vector<define_t> defines;
   std::vector<int> num_warps;  
+  autotune_bucket_t bucket = BUCKET_POW2;
 };
 
 struct options_t {
@@ -65,6 +75,8 @@ struct options_t {
   T D(const std::string& name) const {
     return convert<T>(defines.at(name));
   }
+  // "num_warps=4,D0=v0,D1=v1,..." with sorted defines
+  std::string to_str() const;
   std::unordered_map<std::string, std::string> defines;
   size_t num_warps;
 };
@@ -72,35 +84,74 @@ struct options_t {
 
 /* ------------------------- */
 
+class frontend;
+
 class kernel{
-private:
+public:
+  // declarations prepended to the source of every kernel
   static std::string preheader();
   static arg_type convert(ir::type *ty);
 
 public:
-  kernel(const std::string& src, const options_t& opt, driver::device *device);
+  kernel(const std::string& src, const options_t& opt, driver::device *device, frontend* fe = nullptr);
+  // entry point `entry` of a bundle compiled ahead of time by triton-cc
+  kernel(std::shared_ptr<driver::module> mod, const std::string& entry, const std::vector<arg_type>& sig,
+         const std::vector<std::string>& arg_names, const options_t& opt, driver::device *device);
   void operator()(void* args, size_t args_size, driver::stream *stream, const std::vector<size_t>& grid) const;
   // getters
   const std::vector<arg_type>& get_sig() const { return sig_; }
+  const std::vector<std::string>& get_arg_names() const { return arg_names_; }
+  // time spent in each compilation step
+  const std::vector<codegen::pass_stat_t>& get_compile_stats() const { return pm_.stats(); }
 
 private:
-  void init_ir (const std::string &src);
+  void init_ir (const std::string &src, frontend* fe);
   void init_ker();
   void init_sig();
+  void init_ptr_offsets();
+  // persistent cache
+  std::string cache_path(const std::string& src) const;
+  bool load_from_cache(const std::string& path);
+  void save_to_cache(const std::string& path) const;
 
 public:
   const options_t opt;
 
 private:
   driver::device* dev_;
+  // name of the entry point
+  std::string name_;
   // signature
   std::vector<arg_type> sig_;
+  std::vector<std::string> arg_names_;
   // triton context for parsing
   ir::context ctx_;
   // handles
   std::shared_ptr<ir::module> ir_;
   std::shared_ptr<driver::module> mod_;
   std::shared_ptr<driver::kernel> ker_;
+  // compilation statistics
+  codegen::pass_manager pm_;
+};
+
+// Pre-processes the preheader and the source once for all configurations.
+// Defines that take several values are left symbolic, and their values are
+// substituted in the token stream of each configuration before parsing.
+// Not thread-safe; used under the lock of the front-end.
+class frontend {
+public:
+  frontend(const std::string& src, const options_space_t& opt);
+  // tokens of the program for `opt`; returns false if the source needs the
+  // value of a symbolic define while pre-processing (e.g., in `#if` or `##`),
+  // in which case it must be pre-processed once per configuration
+  bool specialize(TokenSequence& tokens, const options_t& opt);
+
+private:
+  std::string src_;
+  std::vector<std::string> symbols_;
+  std::vector<std::pair<std::string, std::string>> fixed_;
+  std::shared_ptr<TokenSequence> tokens_;
+  bool processed_;
 };
 
 class function {
@@ -108,12 +159,17 @@ public:
   typedef std::function<grid_t(const options_t&)> grid_fn_ty;
   typedef std::pair<options_t, std::shared_ptr<kernel>> kernel_pair_t;
   typedef std::map<std::vector<uint64_t>, kernel*> cache_t;
+  typedef std::pair<std::string, std::vector<codegen::pass_stat_t>> compile_stats_t;
 
 private:
   static void do_loop_nest(std::vector<size_t> const & ranges,
                            std::function<void(std::vector<size_t> const &)> const & f);
 public:
   function(const std::string& src, const options_space_t& opt, driver::device *device);
+  // kernels of the bundle `name`, compiled ahead of time by triton-cc
+  // into the shared library `path`; nothing is compiled at run-time
+  function(const std::string& path, const std::string& name, driver::device *device,
+           autotune_bucket_t bucket = BUCKET_POW2);
   void operator()(void* args, size_t args_size, const grid_fn_ty& grid, driver::stream *stream);
   void operator()(void* args, size_t args_size, const grid_t& grid, driver::stream *stream);
   // auto-tuning
@@ -121,12 +177,17 @@ public:
   kernel* autotune(void* args, size_t args_size, const grid_fn_ty& grid, driver::stream *stream);
   // getters
   const std::vector<kernel_pair_t> get_kernels() { return kernels_; }
+  // compilation statistics of every configuration, labelled by `options_t::to_str()`
+  std::vector<compile_stats_t> get_compile_stats() const;
 
 private:
   void init_kernels(const std::string& src, const options_space_t& opt, driver::device *device);
+  void init_bundle(const std::string& path, const std::string& name, driver::device *device);
+  std::vector<uint64_t> autotune_key(void* args, size_t args_size) const;
 
 private:
   std::vector<kernel_pair_t> kernels_;
+  autotune_bucket_t bucket_;
   std::map<std::vector<uint64_t>, kernel*> cache_;
 };
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef _TRITON_RUNTIME_LAUNCHER_H_
+#define _TRITON_RUNTIME_LAUNCHER_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "triton/runtime/arg.h"
+#include "triton/runtime/function.h"
+
+namespace triton{
+
+namespace driver{
+  class stream;
+}
+
+namespace runtime{
+
+// Launches a function without re-packing its arguments: they are
+// written in place into a buffer whose layout is computed once from
+// the signature, and grids are given as integer expressions that are
+// evaluated natively, e.g. {"cdiv(M, TM)", "cdiv(N, TN)"}.
+// Expressions may use integer literals, the integer arguments of the
+// kernel and the defines of the configuration, + - * / %, parentheses,
+// and the functions cdiv, min and max.
+// Not thread-safe.
+class launcher {
+  struct op_t {
+    enum code_t { CONST, ARG, DEFINE, NEG, ADD, SUB, MUL, DIV, MOD, CDIV, MIN, MAX };
+    code_t code;
+    int64_t val;
+  };
+  typedef std::vector<op_t> expr_t;
+
+  expr_t compile(const std::string& str);
+  int64_t eval(const expr_t& expr, const options_t& opt);
+  int64_t get_int(size_t i) const;
+  const std::vector<int64_t>& get_defines(const options_t& opt);
+
+public:
+  launcher(function* fn);
+  // returns the id of the grid made of the expressions in `grid`
+  size_t add_grid(const std::vector<std::string>& grid);
+  // forgets every grid; their ids become invalid
+  void clear_grids();
+  // location of the i-th argument in the argument buffer
+  char* arg(size_t i) { return (char*)buf_.data() + offsets_[i]; }
+  arg_type type(size_t i) const { return sig_[i]; }
+  size_t num_args() const { return sig_.size(); }
+  // auto-tunes if necessary, then launches with the grid `grid`
+  void operator()(size_t grid, driver::stream* stream);
+
+private:
+  function* fn_;
+  std::vector<arg_type> sig_;
+  std::vector<std::string> names_;
+  std::vector<size_t> offsets_;
+  size_t size_;
+  // 8-byte aligned
+  std::vector<uint64_t> buf_;
+  std::vector<std::vector<expr_t>> grids_;
+  // defines used by grid expressions, and their values in every configuration
+  std::vector<std::string> defines_;
+  std::unordered_map<const options_t*, std::vector<int64_t>> define_vals_;
+};
+
+}
+}
+
+#endif
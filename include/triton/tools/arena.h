@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef _TRITON_TOOLS_ARENA_H_
+#define _TRITON_TOOLS_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+namespace triton{
+namespace tools{
+
+/*
+ * Bump allocator. Memory is handed out from large blocks and only
+ * given back when the arena is destroyed. Objects that need their
+ * destructor to run register a finalizer; finalizers run in reverse
+ * order of registration, before any block is freed.
+ * Not thread-safe.
+ */
+class arena {
+  typedef void(*finalizer_fn_t)(void*);
+  struct finalizer_t {
+    finalizer_fn_t fn;
+    void* ptr;
+  };
+
+public:
+  arena(size_t block_size = 64 << 10)
+    : block_size_(block_size), cur_(nullptr), end_(nullptr), num_bytes_(0) { }
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  ~arena() {
+    for(auto it = finalizers_.rbegin(); it != finalizers_.rend(); ++it)
+      it->fn(it->ptr);
+  }
+
+  void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    uintptr_t ptr = ((uintptr_t)cur_ + align - 1) / align * align;
+    if(!cur_ || ptr + size > (uintptr_t)end_){
+      // large requests get a block of their own, so that
+      // the remainder of the current block is not wasted
+      if(size + align > block_size_ / 4){
+        blocks_.emplace_back(new char[size + align]);
+        num_bytes_ += size + align;
+        uintptr_t base = (uintptr_t)blocks_.back().get();
+        return (void*)((base + align - 1) / align * align);
+      }
+      blocks_.emplace_back(new char[block_size_]);
+      num_bytes_ += block_size_;
+      cur_ = blocks_.back().get();
+      end_ = cur_ + block_size_;
+      ptr = ((uintptr_t)cur_ + align - 1) / align * align;
+    }
+    cur_ = (char*)(ptr + size);
+    return (void*)ptr;
+  }
+
+  void add_finalizer(finalizer_fn_t fn, void* ptr) {
+    finalizers_.push_back({fn, ptr});
+  }
+
+  // for objects whose constructor threw
+  void remove_finalizer(void* ptr) {
+    auto it = std::find_if(finalizers_.rbegin(), finalizers_.rend(),
+                           [ptr](const finalizer_t& x) { return x.ptr == ptr; });
+    if(it != finalizers_.rend())
+      finalizers_.erase(std::next(it).base());
+  }
+
+  size_t num_bytes() const { return num_bytes_; }
+
+private:
+  size_t block_size_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  std::vector<finalizer_t> finalizers_;
+  char* cur_;
+  char* end_;
+  size_t num_bytes_;
+};
+
+}
+}
+
+#endif
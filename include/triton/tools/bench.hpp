@@ -4,10 +4,15 @@
 #define _TRITON_TOOLS_BENCH_H_
 
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
 #include <functional>
 #include <algorithm>
+#include <numeric>
 #include "triton/driver/device.h"
 #include "triton/driver/stream.h"
+#include "triton/driver/buffer.h"
 
 namespace triton{
 namespace tools{
@@ -30,25 +35,142 @@ private:
     high_resolution_clock::time_point _start;
 };
 
-inline double bench(std::function<void()> const & op, driver::stream * stream, bool normalize = false)
-{
-//  const driver::device * device = stream->context()->device();
-  size_t warmup = 10;
-  size_t repeat = 50;
-  timer tmr;
-  std::vector<size_t> times;
-  double total_time = 0;
-  for(size_t i = 0; i < warmup; i++)
-    op();
-  stream->synchronize();
-  tmr.start();
-  for(size_t i = 0; i < repeat; i++){
+struct bench_options_t {
+  size_t warmup = 3;
+  size_t min_repeat = 10;
+  size_t max_repeat = 200;
+  // stop once the 95% confidence interval of the mean
+  // is narrower than `rel_ci` times the median
+  double rel_ci = 0.02;
+  // wall-clock budget of a measurement, flushes included (ns)
+  double max_total_ns = 250e6;
+  // bytes overwritten before every iteration to evict
+  // the last-level cache; 0 disables flushing
+  size_t flush_bytes = 64 << 20;
+};
+
+// per-iteration timings of a measurement, in nanoseconds
+struct bench_result_t {
+  double min() const { return times.front(); }
+  double max() const { return times.back(); }
+  double median() const { return percentile(0.5); }
+  double mean() const { return std::accumulate(times.begin(), times.end(), 0.) / times.size(); }
+  // linear interpolation between closest ranks
+  double percentile(double q) const {
+    double pos = q * (times.size() - 1);
+    size_t lo = (size_t)std::floor(pos);
+    size_t hi = std::min(lo + 1, times.size() - 1);
+    return times[lo] + (pos - lo) * (times[hi] - times[lo]);
+  }
+
+  std::vector<double> times;
+  // set when the measurement stopped early because
+  // the operation could not beat the cutoff
+  bool eliminated = false;
+};
+
+class benchmark {
+  // times one iteration of `op` on a cold cache
+  double run(std::function<void()> const & op) {
+    flush();
+    if(stream_->backend() == driver::CUDA){
+      driver::dispatch::cuEventRecord(start_, *stream_->cu());
+      op();
+      driver::dispatch::cuEventRecord(end_, *stream_->cu());
+      stream_->synchronize();
+      float ms;
+      driver::dispatch::cuEventElapsedTime(&ms, start_, end_);
+      return ms * 1e6;
+    }
+    stream_->synchronize();
+    timer tmr(true);
     op();
+    stream_->synchronize();
+    return tmr.get().count();
+  }
+
+  void flush() {
+    if(!flush_buf_)
+      return;
+    if(stream_->backend() == driver::CUDA)
+      ((driver::cu_buffer*)&*flush_buf_)->set_zero(stream_, opt_.flush_bytes);
+    else
+      std::memset(flush_buf_->hst()->data, 0, opt_.flush_bytes);
+  }
+
+  // whether the confidence interval of the mean has converged
+  bool converged(bench_result_t& res) const {
+    std::vector<double>& t = res.times;
+    double mean = res.mean();
+    double var = 0;
+    for(double x: t)
+      var += (x - mean)*(x - mean);
+    var /= t.size() - 1;
+    std::nth_element(t.begin(), t.begin() + t.size()/2, t.end());
+    double median = t[t.size()/2];
+    return 1.96*std::sqrt(var / t.size()) <= opt_.rel_ci * median;
   }
-  stream->synchronize();
-  return (float)tmr.get().count() / repeat;
 
-//  return *std::min_element(times.begin(), times.end());
+public:
+  benchmark(driver::stream* stream, const bench_options_t& opt = bench_options_t())
+    : stream_(stream), opt_(opt) {
+    opt_.min_repeat = std::max<size_t>(opt_.min_repeat, 2);
+    opt_.max_repeat = std::max(opt_.max_repeat, opt_.min_repeat);
+    if(opt_.flush_bytes > 0){
+      if(stream_->backend() == driver::CUDA)
+        flush_buf_.reset(new driver::cu_buffer(opt_.flush_bytes));
+      else
+        flush_buf_.reset(new driver::host_buffer(opt_.flush_bytes));
+    }
+    if(stream_->backend() == driver::CUDA){
+      driver::dispatch::cuEventCreate(&start_, 0);
+      driver::dispatch::cuEventCreate(&end_, 0);
+    }
+  }
+
+  ~benchmark() {
+    if(stream_->backend() == driver::CUDA){
+      driver::dispatch::cuEventDestroy_v2(start_);
+      driver::dispatch::cuEventDestroy_v2(end_);
+    }
+  }
+
+  // repeats `op` until the timings are stable or the budget is spent;
+  // gives up after `min_repeat` iterations if none of them beat `cutoff`
+  bench_result_t operator()(std::function<void()> const & op, double cutoff = INFINITY) {
+    timer total(true);
+    for(size_t i = 0; i < opt_.warmup; i++)
+      op();
+    stream_->synchronize();
+    bench_result_t res;
+    while(res.times.size() < opt_.max_repeat){
+      res.times.push_back(run(op));
+      if(res.times.size() < opt_.min_repeat)
+        continue;
+      if(res.times.size() == opt_.min_repeat &&
+         *std::min_element(res.times.begin(), res.times.end()) > cutoff){
+        res.eliminated = true;
+        break;
+      }
+      if(converged(res) || total.get().count() > opt_.max_total_ns)
+        break;
+    }
+    std::sort(res.times.begin(), res.times.end());
+    return res;
+  }
+
+private:
+  driver::stream* stream_;
+  bench_options_t opt_;
+  std::unique_ptr<driver::buffer> flush_buf_;
+  CUevent start_;
+  CUevent end_;
+};
+
+// median time of `op`, in nanoseconds
+inline double bench(std::function<void()> const & op, driver::stream * stream, bool normalize = false)
+{
+  return benchmark(stream)(op).median();
 }
 
 }
@@ -3,62 +3,105 @@
 #ifndef _TRITON_TOOLS_THREAD_GRAPH_H_
 #define _TRITON_TOOLS_THREAD_GRAPH_H_
 
-#include <map>
-#include <set>
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 
 namespace triton {
 namespace tools{
 
-template<class node_t>
+// Undirected graph over dense node ids, whose connected components
+// are maintained incrementally with union-find (path halving and
+// union by rank). Nodes are created by the first edge that uses them.
 class graph {
-  typedef std::map<node_t, std::set<node_t>> edges_t;
-
 public:
-  typedef std::map<size_t, std::vector<node_t>> cmap_t;
-  typedef std::map<node_t, size_t> nmap_t;
+  // nodes of every component
+  typedef std::vector<std::vector<size_t>> cmap_t;
+  // component of every node, or npos for ids without edges
+  typedef std::vector<size_t> nmap_t;
+  static const size_t npos = (size_t)-1;
 
 private:
-  void connected_components_impl(node_t x, std::set<node_t> &nodes,
-                                 nmap_t* nmap, cmap_t* cmap, int id) const {
-    if(nmap)
-      (*nmap)[x] = id;
-    if(cmap)
-      (*cmap)[id].push_back(x);
-    if(nodes.find(x) != nodes.end()) {
-      nodes.erase(x);
-      for(const node_t &y: edges_.at(x))
-        connected_components_impl(y, nodes, nmap, cmap, id);
-    }
+  void reserve(size_t x) {
+    if(x < parent_.size())
+      return;
+    size_t n = parent_.size();
+    parent_.resize(x + 1);
+    rank_.resize(x + 1, 0);
+    present_.resize(x + 1, false);
+    for(size_t i = n; i <= x; i++)
+      parent_[i] = i;
   }
 
 public:
-  void connected_components(cmap_t *cmap, nmap_t *nmap) const {
-    if(cmap)
-      cmap->clear();
-    if(nmap)
-      nmap->clear();
-    std::set<node_t> nodes = nodes_;
-    unsigned id = 0;
-    while(!nodes.empty())
-      connected_components_impl(*nodes.begin(), nodes, nmap, cmap, id++);
+  size_t find(size_t x) {
+    if(x >= parent_.size())
+      return x;
+    while(parent_[x] != x){
+      parent_[x] = parent_[parent_[x]];
+      x = parent_[x];
+    }
+    return x;
+  }
+
+  bool connected(size_t x, size_t y) {
+    return find(x) == find(y);
   }
 
-  void add_edge(node_t x, node_t y) {
-    nodes_.insert(x);
-    nodes_.insert(y);
-    edges_[x].insert(y);
-    edges_[y].insert(x);
+  void add_node(size_t x) {
+    reserve(x);
+    present_[x] = true;
+  }
+
+  void add_edge(size_t x, size_t y) {
+    add_node(x);
+    add_node(y);
+    x = find(x);
+    y = find(y);
+    if(x == y)
+      return;
+    if(rank_[x] < rank_[y])
+      std::swap(x, y);
+    parent_[y] = x;
+    if(rank_[x] == rank_[y])
+      rank_[x]++;
+  }
+
+  // components are numbered in the order of their smallest node,
+  // and list their nodes in increasing order
+  void connected_components(cmap_t *cmap, nmap_t *nmap) {
+    size_t n = parent_.size();
+    nmap_t ids(n, size_t(npos));
+    nmap_t root_ids(n, size_t(npos));
+    size_t num_components = 0;
+    for(size_t x = 0; x < n; x++){
+      if(!present_[x])
+        continue;
+      size_t& id = root_ids[find(x)];
+      if(id == npos)
+        id = num_components++;
+      ids[x] = id;
+    }
+    if(cmap){
+      cmap->assign(num_components, {});
+      for(size_t x = 0; x < n; x++)
+        if(ids[x] != npos)
+          (*cmap)[ids[x]].push_back(x);
+    }
+    if(nmap)
+      *nmap = std::move(ids);
   }
 
   void clear() {
-    nodes_.clear();
-    edges_.clear();
+    parent_.clear();
+    rank_.clear();
+    present_.clear();
   }
 
 private:
-  std::set<node_t> nodes_;
-  edges_t edges_;
+  std::vector<size_t> parent_;
+  std::vector<unsigned char> rank_;
+  std::vector<bool> present_;
 };
 
 }
@@ -0,0 +1,162 @@
+#pragma once
+
+#ifndef _TRITON_TOOLS_WORK_STEALING_POOL_H_
+#define _TRITON_TOOLS_WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+namespace triton{
+namespace tools{
+
+/*
+ * Fixed-size pool of workers, each owning a deque of index ranges.
+ * Workers pop from the back of their own deque and steal from the
+ * front of the others'. Completion of a `parallel_for` is tracked
+ * with a single counter per call rather than one future per chunk.
+ */
+class work_stealing_pool {
+public:
+  typedef std::function<void(size_t, size_t)> range_fn_t;
+  typedef std::function<void()> done_fn_t;
+
+private:
+  struct job_t {
+    range_fn_t fn;
+    done_fn_t done;
+    std::atomic<size_t> pending;
+  };
+
+  struct chunk_t {
+    std::shared_ptr<job_t> job;
+    size_t begin;
+    size_t end;
+  };
+
+  struct queue_t {
+    std::mutex mutex;
+    std::deque<chunk_t> chunks;
+  };
+
+private:
+  bool pop(size_t id, chunk_t& chunk) {
+    queue_t& q = *queues_[id];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if(q.chunks.empty())
+      return false;
+    chunk = std::move(q.chunks.back());
+    q.chunks.pop_back();
+    return true;
+  }
+
+  bool steal(size_t id, chunk_t& chunk) {
+    for(size_t n = 1; n < queues_.size(); n++){
+      queue_t& q = *queues_[(id + n) % queues_.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if(q.chunks.empty())
+        continue;
+      chunk = std::move(q.chunks.front());
+      q.chunks.pop_front();
+      return true;
+    }
+    return false;
+  }
+
+  void run(chunk_t& chunk) {
+    num_queued_--;
+    chunk.job->fn(chunk.begin, chunk.end);
+    if(--chunk.job->pending == 0 && chunk.job->done)
+      chunk.job->done();
+    chunk.job.reset();
+  }
+
+  void worker(size_t id) {
+    chunk_t chunk;
+    while(true){
+      if(pop(id, chunk) || steal(id, chunk)){
+        run(chunk);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]{ return stop_ || num_queued_ > 0; });
+      if(stop_ && num_queued_ == 0)
+        return;
+    }
+  }
+
+public:
+  work_stealing_pool(size_t num_threads): num_queued_(0), next_(0), stop_(false) {
+    num_threads = std::max<size_t>(num_threads, 1);
+    for(size_t i = 0; i < num_threads; i++)
+      queues_.emplace_back(new queue_t());
+    for(size_t i = 0; i < num_threads; i++)
+      workers_.emplace_back([this, i]{ worker(i); });
+  }
+
+  ~work_stealing_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for(std::thread& w: workers_)
+      w.join();
+  }
+
+  size_t num_threads() const {
+    return workers_.size();
+  }
+
+  // runs `fn` over [0, n) in chunks of at most `grain` indices
+  // `done` is invoked once, by the worker that retires the last chunk
+  void parallel_for(size_t n, size_t grain, range_fn_t fn, done_fn_t done = done_fn_t()) {
+    if(n == 0){
+      if(done)
+        done();
+      return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    size_t num_chunks = (n + grain - 1) / grain;
+    std::shared_ptr<job_t> job(new job_t());
+    job->fn = std::move(fn);
+    job->done = std::move(done);
+    job->pending = num_chunks;
+    // consecutive chunks go to the same deque so that
+    // neighbouring program instances run on the same core;
+    // jobs that span all workers always start at the first deque,
+    // so that the same range of a job lands on the same worker
+    size_t per_queue = (num_chunks + queues_.size() - 1) / queues_.size();
+    size_t first = num_chunks >= queues_.size() ? 0 : next_++;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      num_queued_ += num_chunks;
+    }
+    for(size_t c = 0; c < num_chunks; c++){
+      queue_t& q = *queues_[(first + c / per_queue) % queues_.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.chunks.push_back(chunk_t{job, c*grain, std::min(n, (c + 1)*grain)});
+    }
+    cv_.notify_all();
+  }
+
+private:
+  std::vector<std::unique_ptr<queue_t>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> num_queued_;
+  std::atomic<size_t> next_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_;
+};
+
+}
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include "triton/ir/instructions.h"
 #include "triton/ir/type.h"
 #include <iostream>
+#include <set>
 
 namespace triton {
 namespace codegen{
@@ -524,6 +525,36 @@ void align::populate(ir::value *v) {
 }
 
 void align::run(ir::module &mod) {
+  // results of instructions that are new or whose operands changed since
+  // the last run are recomputed, together with the results of their users
+  std::map<ir::value*, std::pair<unsigned, std::vector<ir::value*>>> sigs;
+  std::vector<ir::value*> stale;
+  ir::for_each_instruction(mod, [&](ir::instruction* i) {
+    auto& sig = sigs[i] = {i->get_id(), i->ops()};
+    auto it = sigs_.find(i);
+    if(it == sigs_.end() || it->second != sig)
+      stale.push_back(i);
+  });
+  // removed instructions
+  for(const auto& x: sigs_)
+    if(sigs.find(x.first) == sigs.end()){
+      is_constant_.erase(x.first);
+      max_contiguous_.erase(x.first);
+      starting_multiple_.erase(x.first);
+    }
+  sigs_ = std::move(sigs);
+  std::set<ir::value*> erased;
+  while(!stale.empty()){
+    ir::value* v = stale.back();
+    stale.pop_back();
+    if(!erased.insert(v).second)
+      continue;
+    is_constant_.erase(v);
+    max_contiguous_.erase(v);
+    starting_multiple_.erase(v);
+    for(ir::user* u: v->get_users())
+      stale.push_back(u);
+  }
   ir::for_each_value(mod, [this](ir::value* v) { populate(v); } );
 //  ir::for_each_value(mod, [this](ir::value* v) {
 //      if(dynamic_cast<ir::cast_inst*>(v) || dynamic_cast<ir::getelementptr_inst*>(v))
@@ -2,14 +2,25 @@
 #include "triton/ir/utils.h"
 #include "triton/ir/instructions.h"
 #include "triton/ir/type.h"
-#include <iostream>
+#include <stdexcept>
 
 
 namespace triton{
 namespace codegen{
 namespace analysis{
 
-axes::axes() {}
+axes::axes(): num_nodes_(0) {}
+
+size_t axes::node(ir::value* value, unsigned dim) {
+  std::vector<size_t>& ids = nodes_[value];
+  while(ids.size() <= dim)
+    ids.push_back(num_nodes_++);
+  return ids[dim];
+}
+
+void axes::add_edge(ir::value* x, unsigned dx, ir::value* y, unsigned dy) {
+  graph_.add_edge(node(x, dx), node(y, dy));
+}
 
 void axes::update_graph_reduce(ir::instruction *i) {
   auto* red = static_cast<ir::reduce_inst*>(i);
@@ -20,7 +31,7 @@ void axes::update_graph_reduce(ir::instruction *i) {
   for(unsigned d = 0; d < in_shapes.size(); d++){
     if(d == axis)
       continue;
-    graph_.add_edge({i, current++}, {arg, d});
+    add_edge(i, current++, arg, d);
   }
 }
 
@@ -38,9 +49,9 @@ void axes::update_graph_reshape(ir::instruction *i) {
     bool same_shape = res_shapes[d] == op_shapes[current];
     // either add edge between axis or just add a node in the graph
     if(!is_skewed && same_shape)
-      graph_.add_edge({i, d}, {op, current++});
+      add_edge(i, d, op, current++);
     else
-      graph_.add_edge({i, d}, {i, d});
+      add_edge(i, d, i, d);
     // reshaping is skewed
     if(res_shapes[d] > 1 && !same_shape)
       is_skewed = true;
@@ -53,7 +64,7 @@ void axes::update_graph_trans(ir::instruction *i) {
   auto perm = trans->get_perm();
   // add edge between axis perm[d] and axis d
   for(unsigned d = 0; d < perm.size(); d++)
-    graph_.add_edge({i, perm[d]}, {op, d});
+    add_edge(i, perm[d], op, d);
 }
 
 void axes::update_graph_broadcast(ir::instruction *i) {
@@ -65,7 +76,7 @@ void axes::update_graph_broadcast(ir::instruction *i) {
   // add edge between non-broadcast axes
   for(unsigned d = 0; d < shapes.size(); d ++)
     if(op_shapes[d] == shapes[d])
-      graph_.add_edge({i, d}, {op, d});
+      add_edge(i, d, op, d);
 }
 
 void axes::update_graph_dot(ir::instruction *i) {
@@ -76,7 +87,7 @@ void axes::update_graph_dot(ir::instruction *i) {
   ir::value *D = dot->get_operand(2);
   // add edges between result and accumulator
   for(unsigned d = 0; d < shapes.size(); d++)
-    graph_.add_edge({dot, d}, {D, d});
+    add_edge(dot, d, D, d);
 }
 
 void axes::update_graph_elementwise(ir::instruction *i, bool connect_ret) {
@@ -90,8 +101,8 @@ void axes::update_graph_elementwise(ir::instruction *i, bool connect_ret) {
   for(ir::value* opx: i->ops())
   for(ir::value* opy: i->ops()){
     if(connect_ret && !i->get_type()->is_void_ty())
-      graph_.add_edge({i, d}, {opx, d});
-    graph_.add_edge({opx, d}, {opy, d});
+      add_edge(i, d, opx, d);
+    add_edge(opx, d, opy, d);
   }
 }
 
@@ -100,7 +111,7 @@ void axes::update_graph_no_edge(ir::instruction *i) {
     return;
   auto rank = i->get_type()->get_tile_rank();
   for(unsigned d = 0; d < rank; d++)
-    graph_.add_edge({i, d}, {i, d});
+    add_edge(i, d, i, d);
 }
 
 void axes::update_graph(ir::instruction *i) {
@@ -122,7 +133,10 @@ void axes::update_graph(ir::instruction *i) {
 
 
 int axes::get(ir::value *value, unsigned dim) {
-  return axes_.at({value, dim});
+  size_t id = nodes_.at(value).at(dim);
+  if(axes_.at(id) == tools::graph::npos)
+    throw std::out_of_range("axis without edge");
+  return axes_[id];
 }
 
 std::vector<int> axes::get(ir::value *value) {
@@ -135,6 +149,8 @@ std::vector<int> axes::get(ir::value *value) {
 void axes::run(ir::module &mod) {
   // make graph
   graph_.clear();
+  nodes_.clear();
+  num_nodes_ = 0;
   ir::for_each_instruction(mod, [this](ir::instruction *x) {
     update_graph(x);
   });
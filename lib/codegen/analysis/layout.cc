@@ -220,7 +220,7 @@ scanline_layout::scanline_layout(size_t num_warps,
   int contiguous = 1;
   if(ptr){
     int nbits = ptr->get_type()->get_pointer_element_ty()->get_scalar_ty()->get_primitive_size_in_bits();
-    contiguous = std::min<int>(align->contiguous(ptr)[i], 128 / nbits);
+    contiguous = std::min<int>(align->contiguous(ptr)[i], tgt->vector_bits() / nbits);
   }
 
   nts_[i] = clamp(size / num_threads, 1, std::min<int>(contiguous, shape_[i]));
@@ -329,6 +329,16 @@ layouts::layouts(analysis::axes *axes, analysis::align *align, size_t num_warps,
   : axes_(axes), align_(align), num_warps_(num_warps), tgt_(tgt){ }
 
 
+size_t layouts::node(ir::value *v) {
+  auto it = nodes_.find(v);
+  if(it != nodes_.end())
+    return it->second;
+  size_t ret = node_values_.size();
+  nodes_[v] = ret;
+  node_values_.push_back(v);
+  return ret;
+}
+
 void layouts::connect(ir::value *x, ir::value *y) {
   if(x == y)
     return;
@@ -336,6 +346,12 @@ void layouts::connect(ir::value *x, ir::value *y) {
     return;
   if(!y->get_type()->is_tile_ty())
     return;
+  size_t nx = node(x);
+  size_t ny = node(y);
+  graph_.add_node(nx);
+  graph_.add_node(ny);
+  if(graph_.connected(nx, ny))
+    return;
   std::vector<int> x_axes = axes_->get(x);
   std::vector<int> y_axes = axes_->get(y);
   std::set<int> sx_axes(x_axes.begin(), x_axes.end());
@@ -344,24 +360,25 @@ void layouts::connect(ir::value *x, ir::value *y) {
   std::set_intersection(sx_axes.begin(), sx_axes.end(),
                         sy_axes.begin(), sy_axes.end(),
                         std::inserter(common, common.begin()));
-  graph_.add_edge(x, x);
-  graph_.add_edge(y, y);
   if(!common.empty())
-    graph_.add_edge(x, y);
+    graph_.add_edge(nx, ny);
 }
 
 void layouts::make_graph(ir::instruction *i) {
-  for(ir::value* opx: i->ops())
-  for(ir::value* opy: i->ops()){
-    connect(i, opx);
-    connect(opx, opy);
+  // connect is symmetric
+  const std::vector<ir::value*>& ops = i->ops();
+  for(size_t x = 0; x < ops.size(); x++){
+    connect(i, ops[x]);
+    for(size_t y = x + 1; y < ops.size(); y++)
+      connect(ops[x], ops[y]);
   }
 }
 
 void layouts::create(size_t id, const std::vector<ir::value*>& values) {
 //  if(layouts_.find(id) != layouts_.end())
 //    return;
-  auto it_hmma_c = std::find_if(values.begin(), values.end(), &is_hmma_c);
+  // tensor cores only exist on GPUs; host dots of any type use scanline layouts
+  auto it_hmma_c = tgt_->is_gpu() ? std::find_if(values.begin(), values.end(), &is_hmma_c) : values.end();
   auto cmp = [](ir::value* x, ir::value *y) {
     std::pair<int, int> xx = {x->get_type()->get_tile_rank(), x->get_type()->get_tile_num_elements()};
     std::pair<int, int> yy = {y->get_type()->get_tile_rank(), y->get_type()->get_tile_num_elements()};
@@ -399,12 +416,22 @@ void layouts::create(size_t id, const std::vector<ir::value*>& values) {
 void layouts::run(ir::module &mod) {
   // make graph
   graph_.clear();
+  nodes_.clear();
+  node_values_.clear();
   ir::for_each_instruction(mod, [this](ir::instruction* i) {
     make_graph(i);
   });
 
   // connected components
-  graph_.connected_components(&values_, &groups_);
+  tools::graph::cmap_t cmap;
+  graph_.connected_components(&cmap, nullptr);
+  values_.clear();
+  groups_.clear();
+  for(size_t id = 0; id < cmap.size(); id++)
+  for(size_t x: cmap[id]){
+    values_[id].push_back(node_values_[x]);
+    groups_[node_values_[x]] = id;
+  }
 
   // create layouts
   for(const auto& x: values_)
@@ -413,7 +440,9 @@ void layouts::run(ir::module &mod) {
   // create temporaries
   size_t id = values_.size();
   ir::for_each_instruction(mod, [this, &id](ir::instruction* i) {
-    if(auto *red = dynamic_cast<ir::reduce_inst*>(i)) {
+    // host reductions stay within a thread
+    auto *red = dynamic_cast<ir::reduce_inst*>(i);
+    if(red && tgt_->is_gpu()) {
       id++;
       ir::value *arg = red->get_operand(0);
       unsigned axis = red->get_axis();
@@ -443,7 +472,8 @@ void layouts::run(ir::module &mod) {
       layouts_[id] = new shared_layout(out_layout, axes_->get(val), shape, {recoalasce}, val->get_type()->get_scalar_ty(), align_);
       tmp_[recoalasce] = id;
     }
-    if(auto *atom = dynamic_cast<ir::atomic_cas_inst*>(i)){
+    auto *atom = dynamic_cast<ir::atomic_cas_inst*>(i);
+    if(atom && tgt_->is_gpu()){
       id++;
       layouts_[id] = new shared_layout(nullptr, {}, {1}, {atom}, atom->get_type()->get_scalar_ty(), align_);
       tmp_[atom] = id;
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <sstream>
+#include "triton/codegen/pass.h"
+#include "triton/ir/module.h"
+#include "triton/ir/function.h"
+#include "triton/ir/basic_block.h"
+
+namespace triton{
+namespace codegen{
+
+static double now_us() {
+  auto t = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double, std::micro>(t).count();
+}
+
+size_t pass_manager::num_instructions(ir::module& m) {
+  size_t result = 0;
+  for(ir::function* fn: m.get_function_list())
+  for(ir::basic_block* block: fn->blocks())
+    result += block->get_inst_list().size();
+  return result;
+}
+
+size_t pass_manager::count(ir::module& m) {
+  if(counted_ != &m || counted_version_ != m.get_version()){
+    counted_ = &m;
+    counted_version_ = m.get_version();
+    count_ = num_instructions(m);
+  }
+  return count_;
+}
+
+void pass_manager::run(const std::string& name, ir::module& m, const std::function<void()>& fn) {
+  size_t before = count(m);
+  double start = now_us();
+  fn();
+  double end = now_us();
+  stats_.push_back({name, start, end - start, before, count(m)});
+}
+
+void pass_manager::run(const std::string& name, const std::function<void()>& fn) {
+  double start = now_us();
+  fn();
+  stats_.push_back({name, start, now_us() - start, 0, 0});
+}
+
+void pass_manager::run(const schedule_t& schedule, ir::module& m) {
+  std::map<std::string, const pass_t*> analyses;
+  for(const pass_t& pass: schedule)
+    if(pass.kind == pass_t::ANALYSIS)
+      analyses[pass.name] = &pass;
+  // analyses whose results are up to date
+  std::set<std::string> valid;
+  // module left by the last run of every idempotent transform
+  std::map<std::string, uint64_t> outputs;
+  uint64_t current = m.get_version();
+  for(const pass_t& pass: schedule){
+    if(pass.kind == pass_t::ANALYSIS){
+      if(valid.insert(pass.name).second)
+        run(pass.name, m, [&]() { pass.run(m); });
+      continue;
+    }
+    auto it = outputs.find(pass.name);
+    if(pass.idempotent && it != outputs.end() && it->second == current)
+      continue;
+    run(pass.name, m, [&]() { pass.run(m); });
+    uint64_t next = m.get_version();
+    if(pass.idempotent)
+      outputs[pass.name] = next;
+    if(next == current)
+      continue;
+    current = next;
+    // invalidate the analyses that the transform does not preserve,
+    // then the analyses computed from invalid ones
+    std::set<std::string> preserved(pass.deps.begin(), pass.deps.end());
+    for(auto jt = valid.begin(); jt != valid.end();)
+      jt = preserved.count(*jt) ? std::next(jt) : valid.erase(jt);
+    for(bool changed = true; changed;){
+      changed = false;
+      for(auto jt = valid.begin(); jt != valid.end();){
+        const pass_t* analysis = analyses.at(*jt);
+        bool stale = false;
+        for(const std::string& dep: analysis->deps)
+          stale = stale || (analyses.count(dep) && !valid.count(dep));
+        changed = changed || stale;
+        jt = stale ? valid.erase(jt) : std::next(jt);
+      }
+    }
+  }
+}
+
+std::string escape(const std::string& str) {
+  std::string result;
+  for(char c: str){
+    if(c == '"' || c == '\\')
+      result += '\\';
+    if((unsigned char)c < 0x20){
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      result += buf;
+    }
+    else
+      result += c;
+  }
+  return result;
+}
+
+std::string to_json(const std::vector<pass_stat_t>& stats) {
+  std::ostringstream oss;
+  oss << "[";
+  for(size_t i = 0; i < stats.size(); i++){
+    const pass_stat_t& s = stats[i];
+    oss << (i ? ", " : "")
+        << "{\"name\": \"" << escape(s.name) << "\""
+        << ", \"start_us\": " << std::fixed << s.start_us
+        << ", \"time_us\": " << s.time_us
+        << ", \"num_insts_before\": " << s.num_insts_before
+        << ", \"num_insts_after\": " << s.num_insts_after << "}";
+  }
+  oss << "]";
+  return oss.str();
+}
+
+std::string to_chrome_trace(const std::vector<std::pair<std::string, std::vector<pass_stat_t>>>& rows) {
+  std::ostringstream oss;
+  oss << std::fixed << "{\"traceEvents\": [";
+  bool first = true;
+  for(size_t tid = 0; tid < rows.size(); tid++){
+    // row label
+    oss << (first ? "" : ", ")
+        << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << tid
+        << ", \"args\": {\"name\": \"" << escape(rows[tid].first) << "\"}}";
+    first = false;
+    for(const pass_stat_t& s: rows[tid].second)
+      oss << ", {\"name\": \"" << escape(s.name) << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << tid
+          << ", \"ts\": " << s.start_us << ", \"dur\": " << s.time_us
+          << ", \"args\": {\"num_insts_before\": " << s.num_insts_before
+          << ", \"num_insts_after\": " << s.num_insts_after << "}}";
+  }
+  oss << "], \"displayTimeUnit\": \"ms\"}";
+  return oss.str();
+}
+
+}
+}
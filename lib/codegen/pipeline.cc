@@ -0,0 +1,89 @@
+#include "triton/codegen/pipeline.h"
+#include "triton/codegen/target.h"
+#include "triton/codegen/analysis/axes.h"
+#include "triton/codegen/analysis/allocation.h"
+#include "triton/codegen/analysis/liveness.h"
+#include "triton/codegen/analysis/align.h"
+#include "triton/codegen/analysis/swizzle.h"
+#include "triton/codegen/transform/coalesce.h"
+#include "triton/codegen/transform/dce.h"
+#include "triton/codegen/transform/peephole.h"
+#include "triton/codegen/transform/membar.h"
+#include "triton/codegen/transform/reassociate.h"
+#include "triton/codegen/transform/cts.h"
+#include "triton/codegen/transform/disassociate.h"
+#include "triton/codegen/selection/generator.h"
+
+namespace triton{
+namespace codegen{
+
+pipeline::pipeline(target* tgt, unsigned num_warps) {
+  bool is_gpu = tgt->is_gpu();
+  bool cts_use_async = is_gpu && tgt->as_nvidia()->sm() >= 80;
+  // create passes
+  align_.reset(new analysis::align());
+  axes_.reset(new analysis::axes());
+  cts_.reset(new transform::cts(cts_use_async));
+  disassociate_.reset(new transform::disassociate());
+  layouts_.reset(new analysis::layouts(&*axes_, &*align_, num_warps, tgt));
+  liveness_.reset(new analysis::liveness(&*layouts_));
+  swizzle_.reset(new analysis::swizzle(&*layouts_, tgt));
+  allocation_.reset(new analysis::allocation(&*liveness_));
+  barriers_.reset(new transform::membar(&*liveness_, &*layouts_, &*allocation_));
+  dce_.reset(new transform::dce());
+  peephole_.reset(new transform::peephole(tgt));
+  reassociate_.reset(new transform::reassociate());
+  coalesce_.reset(new transform::coalesce(&*align_, &*layouts_));
+  isel_.reset(new generator(&*axes_, &*layouts_, &*align_, &*allocation_, &*swizzle_, tgt, num_warps));
+  // schedule
+  pass_t dce = make_transform("dce", *dce_, {"align"}, true);
+  schedule_ = {
+    dce,
+    make_transform("disassociate", *disassociate_),
+    dce,
+    make_transform("peephole", *peephole_),
+    dce,
+    make_analysis("align", *align_)
+  };
+  if(is_gpu)
+    schedule_.push_back(make_transform("cts", *cts_));
+  schedule_.insert(schedule_.end(), {
+    make_analysis("axes", *axes_),
+    make_analysis("layouts", *layouts_, {"axes", "align"}),
+    make_transform("coalesce", *coalesce_),
+    dce,
+    make_analysis("align", *align_),
+    dce
+  });
+  if(is_gpu){
+    schedule_.push_back(make_transform("reassociate", *reassociate_));
+    schedule_.push_back(make_transform("cts", *cts_));
+  }
+  schedule_.insert(schedule_.end(), {
+    make_transform("peephole", *peephole_),
+    dce,
+    make_analysis("align", *align_),
+    make_analysis("axes", *axes_),
+    make_analysis("layouts", *layouts_, {"axes", "align"}),
+    make_analysis("swizzle", *swizzle_, {"layouts"}),
+    make_analysis("liveness", *liveness_, {"layouts"}),
+    make_analysis("allocation", *allocation_, {"liveness"})
+  });
+}
+
+pipeline::~pipeline() { }
+
+size_t pipeline::allocated_size() const {
+  return allocation_->allocated_size();
+}
+
+void pipeline::insert_barriers(ir::module& m) {
+  barriers_->run(m);
+}
+
+void pipeline::generate(ir::module& m, llvm::Module& llvm) {
+  isel_->visit(m, llvm);
+}
+
+}
+}
@@ -195,8 +195,58 @@ void generator::visit_value(ir::value* v) {
  */
 void generator::visit_phi_node(ir::phi_node* x) {
   Type *ty = cvt(x->get_type()->get_scalar_ty());
-  for(indices_t idx: idxs_.at(x))
-    vals_[x][idx] = phi(ty, x->get_num_operands());
+  tile_vals_t& dst = vals_[x];
+  for(size_t i = 0; i < dst.size(); i++)
+    dst[i] = phi(ty, x->get_num_operands());
+}
+
+/**
+ * \brief Number of consecutive elements of `x` lowered as a single
+ * SIMD vector (host back-end only)
+ */
+size_t generator::vector_width(ir::value *x) {
+  if(tgt_->is_gpu() || !x->get_type()->is_tile_ty())
+    return 1;
+  if(x->get_type()->get_scalar_ty()->is_pointer_ty())
+    return 1;
+  analysis::scanline_layout* layout = layouts_->get(x)->to_scanline();
+  if(!layout)
+    return 1;
+  return layout->nts(ords_.at(x)[0]);
+}
+
+/**
+ * \brief Code Generation for element-wise instructions.
+ * On the host, operands are packed into vectors along the contiguous axis
+ */
+void generator::visit_elementwise(ir::instruction *x, const elementwise_fn_t& fn) {
+  size_t vec = vector_width(x);
+  for(ir::value *op: x->ops())
+    vec = std::min(vec, vector_width(op));
+  tile_vals_t& dst = vals_[x];
+  const tile_idx_t* idx = dst.index();
+  std::vector<tile_vals_t*> srcs;
+  for(ir::value *op: x->ops())
+    srcs.push_back(&vals_[op]);
+  for(size_t i = 0; i < dst.size(); i += vec){
+    std::vector<Value*> ops;
+    for(tile_vals_t *src: srcs){
+      Value *val = src->at(idx, i);
+      if(vec > 1){
+        Value *packed = UndefValue::get(vec_ty(val->getType(), vec));
+        for(size_t ii = 0; ii < vec; ii++)
+          packed = insert_elt(packed, src->at(idx, i + ii), ii);
+        val = packed;
+      }
+      ops.push_back(val);
+    }
+    Value *ret = fn(ops, vec);
+    if(vec == 1)
+      dst[i] = ret;
+    else
+      for(size_t ii = 0; ii < vec; ii++)
+        dst[i + ii] = extract_elt(ret, ii);
+  }
 }
 
 /**
@@ -228,24 +278,25 @@ void generator::visit_binary_operator(ir::binary_operator*x) {
       default: throw std::runtime_error("unreachable switch");
     }
   };
-  for(indices_t idx: idxs_.at(x)){
-    Value *lhs = vals_[x->get_operand(0)][idx];
-    Value *rhs = vals_[x->get_operand(1)][idx];
-    vals_[x][idx] = bin_op(cvt(x->get_op()), lhs, rhs);
-  }
+  auto op = cvt(x->get_op());
+  visit_elementwise(x, [&](const std::vector<Value*>& ops, size_t) {
+    return bin_op(op, ops[0], ops[1]);
+  });
 }
 
 /**
  * \brief Code Generation for `getelementptr`
  */
 void generator::visit_getelementptr_inst(ir::getelementptr_inst* x) {
-  for(indices_t idx: idxs_.at(x)){
-    Value *ptr = vals_[x->get_pointer_operand()][idx];
+  tile_vals_t& dst = vals_[x];
+  const tile_idx_t* idx = dst.index();
+  tile_vals_t& ptrs = vals_[x->get_pointer_operand()];
+  Type *ty = cvt(x->get_source_elt_ty()->get_scalar_ty());
+  for(size_t i = 0; i < dst.size(); i++){
     std::vector<Value*> vals;
     for(auto it= x->idx_begin(); it != x->idx_end(); it++)
-      vals.push_back(vals_[*it][idx]);
-    Type *ty = cvt(x->get_source_elt_ty()->get_scalar_ty());
-    vals_[x][idx] = gep(ty, ptr, vals);
+      vals.push_back(vals_[*it].at(idx, i));
+    dst[i] = gep(ty, ptrs.at(idx, i), vals);
   }
 }
 
@@ -273,11 +324,10 @@ void generator::visit_icmp_inst(ir::icmp_inst* x) {
     }
   };
 
-  for(indices_t idx: idxs_.at(x)){
-    Value *lhs = vals_[x->get_operand(0)][idx];
-    Value *rhs = vals_[x->get_operand(1)][idx];
-    vals_[x][idx] = icmp(cvt(x->get_pred()), lhs, rhs);
-  }
+  auto pred = cvt(x->get_pred());
+  visit_elementwise(x, [&](const std::vector<Value*>& ops, size_t) {
+    return icmp(pred, ops[0], ops[1]);
+  });
 }
 
 /**
@@ -309,11 +359,10 @@ void generator::visit_fcmp_inst(ir::fcmp_inst* x) {
       default: throw std::runtime_error("unreachable switch");
     }
   };
-  for(indices_t idx: idxs_.at(x)){
-    Value *lhs = vals_[x->get_operand(0)][idx];
-    Value *rhs = vals_[x->get_operand(1)][idx];
-    vals_[x][idx] = fcmp(cvt(x->get_pred()), lhs, rhs);
-  }
+  auto pred = cvt(x->get_pred());
+  visit_elementwise(x, [&](const std::vector<Value*>& ops, size_t) {
+    return fcmp(pred, ops[0], ops[1]);
+  });
 }
 
 /**
@@ -341,10 +390,10 @@ void generator::visit_cast_inst(ir::cast_inst* x) {
       default: throw std::runtime_error("unreachable switch");
     }
   };
-  for(indices_t idx: idxs_.at(x)){
-    Value *arg = vals_[x->get_operand(0)][idx];
-    vals_[x][idx] = cast(cvt(x->get_op()), arg, ty);
-  }
+  auto op = cvt(x->get_op());
+  visit_elementwise(x, [&](const std::vector<Value*>& ops, size_t vec) {
+    return cast(op, ops[0], vec > 1 ? vec_ty(ty, vec) : ty);
+  });
 }
 
 /**
@@ -391,12 +440,20 @@ void generator::visit_load_inst(ir::load_inst* x){
     vec = std::min(nts, aln);
   }
 
+  // host pointers are only known to be aligned on their element type
+  auto do_load = [&](Value *ptr) {
+    LoadInst *ret = load(ptr);
+    if(!tgt_->is_gpu())
+      ret->setAlignment(Align(std::max<unsigned>(ty->getScalarSizeInBits() / 8, 1)));
+    return ret;
+  };
+
   // code generation
-  auto idxs = idxs_.at(x);
-  for(size_t i = 0; i < idxs.size(); i += vec){
-    indices_t idx = idxs[i];
+  tile_vals_t& dst = vals_[x];
+  const tile_idx_t* idx = dst.index();
+  for(size_t i = 0; i < dst.size(); i += vec){
     // pointer value
-    Value *ptr = bit_cast(vals_[op][idx], ptr_ty(vec_ty(ty, vec), space));
+    Value *ptr = bit_cast(vals_[op].at(idx, i), ptr_ty(vec_ty(ty, vec), space));
     // masked load
     Value *ret = nullptr;
     if(mx){
@@ -407,21 +464,21 @@ void generator::visit_load_inst(ir::load_inst* x){
       PHINode *_ret = phi(ptr->getType()->getPointerElementType(), 2);
       Instruction *then_term;
       Instruction *else_term;
-      llvm::SplitBlockAndInsertIfThenElse(vals_[mx->get_mask_operand()][idx], _ret, &then_term, &else_term);
+      llvm::SplitBlockAndInsertIfThenElse(vals_[mx->get_mask_operand()].at(idx, i), _ret, &then_term, &else_term);
       builder_->SetInsertPoint(then_term);
-      Value* then_ret = load(ptr);
+      Value* then_ret = do_load(ptr);
       builder_->SetInsertPoint(else_term);
-      Value* else_ret = splat(vec, vals_[mx->get_false_value_operand()][idx]);
+      Value* else_ret = splat(vec, vals_[mx->get_false_value_operand()].at(idx, i));
       builder_->SetInsertPoint(_ret->getParent());
       _ret->addIncoming(then_ret, then_term->getParent());
       _ret->addIncoming(else_ret, else_term->getParent());
       ret = (Value*)_ret;
     }
     else
-      ret = load(ptr);
+      ret = do_load(ptr);
     // write back
     for(size_t ii = 0; ii < vec; ii++)
-      vals_[x][idxs[i+ii]] = extract_elt(ret, ii);
+      dst[i+ii] = extract_elt(ret, ii);
   }
 }
 void generator::visit_unmasked_load_inst(ir::unmasked_load_inst* x) {
@@ -447,27 +504,33 @@ void generator::visit_store_inst(ir::store_inst * x){
     size_t nts = axes_.at(a_axes_->get(x->get_pointer_operand(), ord[0])).contiguous;
     vec  = std::min(nts, aln);
   }
-  auto idxs    = idxs_.at(val_op);
+  tile_vals_t& vals = vals_[val_op];
+  const tile_idx_t* idx = vals.index();
   Type *ty = cvt(val_op->get_type()->get_scalar_ty());
-  for(size_t i = 0; i < idxs.size(); i += vec){
-    auto idx = idxs[i];
+  // host pointers are only known to be aligned on their element type
+  auto do_store = [&](Value *val, Value *ptr) {
+    StoreInst *ret = store(val, ptr);
+    if(!tgt_->is_gpu())
+      ret->setAlignment(Align(std::max<unsigned>(ty->getScalarSizeInBits() / 8, 1)));
+  };
+  for(size_t i = 0; i < vals.size(); i += vec){
     // pointer
-    Value *ptr = vals_[ptr_op][idx];
+    Value *ptr = vals_[ptr_op].at(idx, i);
     ptr = bit_cast(ptr, vec_ty(ty, vec)->getPointerTo(1));
     // value
     Value* val = UndefValue::get(vec_ty(ty, vec));
     for(size_t ii = 0; ii < vec; ii++)
-      val = insert_elt(val, vals_.at(val_op)[idxs[i + ii]], ii);
+      val = insert_elt(val, vals[i + ii], ii);
     if(mx){
-      Value *msk = vals_[mx->get_mask_operand()][idx];
+      Value *msk = vals_[mx->get_mask_operand()].at(idx, i);
       Instruction *no_op = intrinsic(Intrinsic::donothing, {}, {});
       Instruction *term = llvm::SplitBlockAndInsertIfThen(msk, no_op, false);
       builder_->SetInsertPoint(term);
-      store(val, ptr);
+      do_store(val, ptr);
       builder_->SetInsertPoint(no_op);
     }
     else
-      store(val, ptr);
+      do_store(val, ptr);
   }
 }
 void generator::visit_unmasked_store_inst(ir::unmasked_store_inst* x) {
@@ -481,19 +544,20 @@ void generator::visit_masked_store_inst(ir::masked_store_inst* x) {
  * \brief Code Generation for `reshape`
  */
 void generator::visit_reshape_inst(ir::reshape_inst* x) {
-  auto idxs = idxs_.at(x);
-  for(size_t i = 0; i < idxs_.at(x).size(); i ++){
-    ir::value* op = x->get_operand(0);
-    vals_[x][idxs_[x][i]] = vals_[op][idxs_[op][i]];
-  };
+  tile_vals_t& dst = vals_[x];
+  tile_vals_t& src = vals_[x->get_operand(0)];
+  for(size_t i = 0; i < dst.size(); i ++)
+    dst[i] = src[i];
 }
 
 /**
  * \brief Code Generation for `splat`
  */
 void generator::visit_splat_inst(ir::splat_inst* x) {
-  for(auto idx: idxs_.at(x))
-    vals_[x][idx] = vals_[x->get_operand(0)][{}];
+  tile_vals_t& dst = vals_[x];
+  Value *val = vals_[x->get_operand(0)][0];
+  for(size_t i = 0; i < dst.size(); i++)
+    dst[i] = val;
 }
 
 /**
@@ -502,7 +566,7 @@ void generator::visit_splat_inst(ir::splat_inst* x) {
 void generator::visit_broadcast_inst(ir::broadcast_inst* x) {
   ir::value* op = x->get_operand(0);
   const auto& shape = op->get_type()->get_tile_shapes();
-  for(auto out_idx: idxs_.at(x)){
+  for(auto out_idx: get_idxs(x)){
     indices_t in_idx = out_idx;
     for(size_t k = 0; k < in_idx.size(); k++)
       in_idx[k] = shape[k] == 1 ? i32(0) : in_idx[k];
@@ -539,13 +603,21 @@ void generator::visit_get_num_program_inst(ir::get_num_program_inst* np) {
  * \brief Code Generation for `exp`
  */
 void generator::visit_exp_inst(ir::exp_inst* x){
+  if(!tgt_->is_gpu()){
+    visit_elementwise(x, [&](const std::vector<Value*>& ops, size_t) {
+      return intrinsic(Intrinsic::exp, {ops[0]->getType()}, {ops[0]});
+    });
+    return;
+  }
   Constant *log2e = ConstantFP::get(f32_ty, 1.4426950408889634);
   std::vector<llvm::Type*> tys = {f32_ty};
   FunctionType *fn_ty = FunctionType::get(f32_ty, tys, false);
   InlineAsm *ex2 = InlineAsm::get(fn_ty, "ex2.approx.f32 $0, $1;", "=f,f", false);
-  for(auto idx: idxs_.at(x)){
-    Value *ex2arg = fmul(vals_[x->get_operand(0)][idx], log2e);
-    vals_[x][idx] = call(ex2, std::vector<llvm::Value*>{ex2arg});
+  tile_vals_t& dst = vals_[x];
+  tile_vals_t& src = vals_[x->get_operand(0)];
+  for(size_t i = 0; i < dst.size(); i++){
+    Value *ex2arg = fmul(src.at(dst.index(), i), log2e);
+    dst[i] = call(ex2, std::vector<llvm::Value*>{ex2arg});
   }
 }
 
@@ -553,13 +625,21 @@ void generator::visit_exp_inst(ir::exp_inst* x){
  * \brief Code Generation for `log`
  */
 void generator::visit_log_inst(ir::log_inst* x){
+  if(!tgt_->is_gpu()){
+    visit_elementwise(x, [&](const std::vector<Value*>& ops, size_t) {
+      return intrinsic(Intrinsic::log, {ops[0]->getType()}, {ops[0]});
+    });
+    return;
+  }
   Constant *rcplog2e = ConstantFP::get(f32_ty, 0.6931471805599453);
   std::vector<llvm::Type*> tys = {f32_ty};
   FunctionType *fn_ty = FunctionType::get(f32_ty, tys, false);
   InlineAsm *lg2 = InlineAsm::get(fn_ty, "lg2.approx.f32 $0, $1;", "=f,f", false);
-  for(auto idx: idxs_.at(x)){
-    Value *lg2arg = call(lg2, std::vector<llvm::Value*>{vals_[x->get_operand(0)][idx]});
-    vals_[x][idx] = fmul(lg2arg, rcplog2e);
+  tile_vals_t& dst = vals_[x];
+  tile_vals_t& src = vals_[x->get_operand(0)];
+  for(size_t i = 0; i < dst.size(); i++){
+    Value *lg2arg = call(lg2, std::vector<llvm::Value*>{src.at(dst.index(), i)});
+    dst[i] = fmul(lg2arg, rcplog2e);
   }
 }
 
@@ -567,6 +647,13 @@ void generator::visit_log_inst(ir::log_inst* x){
  * \brief Code Generation for `atomic_cas`
  */
 void generator::visit_atomic_cas_inst(ir::atomic_cas_inst* cas) {
+  // host programs are single-threaded: no broadcast through shared memory
+  if(!tgt_->is_gpu()){
+    Value *old = atomic_cmp_xchg(vals_[cas->get_operand(0)][{}], vals_[cas->get_operand(1)][{}], vals_[cas->get_operand(2)][{}],
+                                 AtomicOrdering::AcquireRelease, AtomicOrdering::Acquire);
+    vals_[cas][{}] = extract_val(old, std::vector<unsigned>{0});
+    return;
+  }
   BasicBlock *current = builder_->GetInsertBlock();
   Module *module = current->getModule();
   Value *tid = tgt_->get_local_id(module, *builder_, 0);
@@ -601,6 +688,10 @@ void generator::visit_atomic_exch_inst(ir::atomic_exch_inst* xchg) {
   Module *module = current->getModule();
   Value *rmw_ptr = vals_[xchg->get_operand(0)][{}];
   Value *rmw_val = vals_[xchg->get_operand(1)][{}];
+  if(!tgt_->is_gpu()){
+    vals_[xchg][{}] = atomic_rmw(AtomicRMWInst::Xchg, rmw_ptr, rmw_val, AtomicOrdering::AcquireRelease, SyncScope::System);
+    return;
+  }
   Value *tid = tgt_->get_local_id(module, *builder_, 0);
   Value *pred = icmp_eq(tid, i32(0));
   BasicBlock *tid_0_bb = BasicBlock::Create(*ctx_, "tid_0", current->getParent());
@@ -620,6 +711,23 @@ void generator::visit_atomic_exch_inst(ir::atomic_exch_inst* xchg) {
  */
 //TODO: clean-up
 void generator::visit_atomic_add_inst(ir::atomic_add_inst* add) {
+  // host: one (masked) atomicrmw per element
+  if(!tgt_->is_gpu()){
+    ir::value* ptr = add->get_operand(0);
+    ir::value* val = add->get_operand(1);
+    ir::value* msk = add->get_operand(2);
+    for(const indices_t& idx: get_idxs(val)){
+      Value *rmw_val = vals_[val][idx];
+      bool is_fp = rmw_val->getType()->isFloatingPointTy();
+      Instruction *no_op = intrinsic(Intrinsic::donothing, {}, {});
+      Instruction *term = llvm::SplitBlockAndInsertIfThen(vals_[msk][idx], no_op, false);
+      builder_->SetInsertPoint(term);
+      atomic_rmw(is_fp ? AtomicRMWInst::FAdd : AtomicRMWInst::Add, vals_[ptr][idx], rmw_val,
+                 AtomicOrdering::Monotonic, SyncScope::System);
+      builder_->SetInsertPoint(no_op);
+    }
+    return;
+  }
 
   if(add->get_type()->is_tile_ty()){
     ir::value* ptr = add->get_operand(0);
@@ -633,11 +741,11 @@ void generator::visit_atomic_add_inst(ir::atomic_add_inst* add) {
     vec = std::min<int>(layouts_->get(ptr)->to_scanline()->nts(ld), alignment);
     vec = std::min(vec, val->get_type()->get_tile_element_ty()->is_half_ty() ? 2 : 1);
 
-    for(int i = 0; i < idxs_.at(val).size(); i += vec){
-      auto idx = idxs_[val][i];
+    for(int i = 0; i < get_idxs(val).size(); i += vec){
+      auto idx = get_idxs(val)[i];
       Value *rmw_val = UndefValue::get(vec_ty(vals_[val][idx]->getType(), vec));
       for(int ii = 0; ii < vec; ii++)
-        rmw_val = insert_elt(rmw_val, vals_[val][idxs_[val][i+ii]], ii);
+        rmw_val = insert_elt(rmw_val, vals_[val][get_idxs(val)[i+ii]], ii);
       Value *rmw_ptr = vals_[ptr][idx];
       Value *rmw_msk = vals_[msk][idx];
       if(vec == 1)
@@ -803,7 +911,7 @@ void generator::visit_mma884(ir::dot_inst* C, ir::value *A, ir::value *B, ir::va
 
   // initialize accumulators
   std::vector<Value*> acc;
-  for(indices_t idx: idxs_.at(C))
+  for(const indices_t& idx: get_idxs(C))
     acc.push_back(vals_[D][idx]);
 
   // update accumulators
@@ -868,8 +976,8 @@ void generator::visit_mma884(ir::dot_inst* C, ir::value *A, ir::value *B, ir::va
   }
 
   // write back accumulators
-  for(size_t i = 0; i < idxs_.at(C).size(); i++)
-    vals_[C][idxs_[C][i]] = acc[i];
+  for(size_t i = 0; i < get_idxs(C).size(); i++)
+    vals_[C][get_idxs(C)[i]] = acc[i];
 }
 
 /**
@@ -881,7 +989,7 @@ void generator::visit_mma16816(ir::dot_inst* dot, ir::value *A, ir::value *B, ir
 
   std::map<std::vector<Value*>, std::vector<Value*>> fcs;
 
-  for(indices_t idx: idxs_.at(dot)){
+  for(const indices_t& idx: get_idxs(dot)){
     std::vector<Value*> key(idx.size() - 2);
     std::copy(idx.begin() + 2, idx.end(), key.begin());
     fcs[key].push_back(vals_[D][idx]);
@@ -1046,7 +1154,7 @@ void generator::visit_mma16816(ir::dot_inst* dot, ir::value *A, ir::value *B, ir
 
   // write back
   unsigned i = 0;
-  for(indices_t idx: idxs_.at(dot)){
+  for(const indices_t& idx: get_idxs(dot)){
     std::vector<Value*> key(idx.size() - 2);
     std::copy(idx.begin() + 2, idx.end(), key.begin());
     if(i >= fcs.at(key).size())
@@ -1120,7 +1228,8 @@ void generator::visit_fmadot(ir::dot_inst* C, ir::value* A, ir::value* B, ir::va
   for(int i = 0; i < num_ptr_b; i++)
     ptrs_b[i] = gep(shmems_[B], off_b[i]);
 
-  std::map<indices_t, Value*> ret = vals_[D];
+  tile_vals_t ret = vals_[D];
+  const tile_idx_t* idx_c = vals_[C].index();
   std::map<std::pair<int, int>, Value*> has, hbs;
   for(unsigned k = 0; k < NK; k++){
     int z = 0;
@@ -1139,14 +1248,160 @@ void generator::visit_fmadot(ir::dot_inst* C, ir::value* A, ir::value* B, ir::va
         Value* vb = load(pb);
         hbs[{n + nn, k}] = vb;
       }
-      ret[idxs_[C].at(z)] = call(f_mul_add, {has[{m+mm,k}], hbs[{n+nn, k}], ret[idxs_[C].at(z)]});
+      ret.at(idx_c, z) = call(f_mul_add, {has[{m+mm,k}], hbs[{n+nn, k}], ret.at(idx_c, z)});
       z++;
     }
   }
 
-  for(indices_t idx: idxs_.at(C)){
-    vals_[C][idx] = ret[idx];
+  for(size_t i = 0; i < idx_c->idxs.size(); i++)
+    vals_[C][i] = ret.at(idx_c, i);
+}
+
+/**
+ * \brief Code Generation for `dot` (host case)
+ * Operands are spilled to a scratch buffer and multiplied by a loop nest
+ * around a register-blocked micro-kernel: an MR x (NR*W) block of C is
+ * kept in MR*NR vector accumulators and updated with one broadcast of A
+ * and NR vector loads of B per step of k
+ */
+void generator::visit_cpudot(ir::dot_inst* C, ir::value* A, ir::value* B, ir::value* D, unsigned NK, Type *c_ty) {
+  auto shape_c = C->get_type()->get_tile_shapes();
+  unsigned M = shape_c[0];
+  unsigned N = shape_c[1];
+  unsigned K = NK;
+  Function *fn = builder_->GetInsertBlock()->getParent();
+  // micro-kernel size: W lanes per vector, MR*NR accumulators
+  // (16 with 32 zmm registers, 8 with 16 ymm/xmm registers)
+  unsigned W  = std::max<unsigned>(tgt_->vector_bits() / c_ty->getScalarSizeInBits(), 1);
+  unsigned MR = tgt_->vector_bits() >= 512 ? 8 : 4;
+  unsigned NR = 2;
+  while(N % (NR*W) != 0){
+    if(NR > 1) NR /= 2;
+    else       W  /= 2;
+  }
+  while(M % MR != 0)
+    MR /= 2;
+  // coordinates of the elements of a tile
+  auto positions = [&](ir::value *v) {
+    std::vector<std::map<Value*, unsigned>> result(2);
+    auto shapes = v->get_type()->get_tile_shapes();
+    for(unsigned d = 0; d < 2; d++){
+      if(shapes[d] == 1){
+        result[d][i32(0)] = 0;
+        continue;
+      }
+      const std::vector<Value*>& values = axes_.at(a_axes_->get(v, d)).values;
+      for(unsigned p = 0; p < values.size(); p++)
+        result[d][values[p]] = p;
+    }
+    return result;
+  };
+  // scratch buffer for A, B and C. it is on the stack of the worker up to
+  // 64 KB, where the lifetime markers let the dots of a kernel share it,
+  // and on the heap for larger tiles, whose products dwarf the allocation
+  unsigned num_elts = M*K + K*N + M*N;
+  uint64_t num_bytes = uint64_t(num_elts) * c_ty->getScalarSizeInBits() / 8;
+  ConstantInt *size = builder_->getInt64(num_bytes);
+  bool on_stack = num_bytes <= (64 << 10);
+  Type *i8_ptr_ty = builder_->getInt8PtrTy();
+  Value *buf;
+  if(on_stack){
+    BasicBlock &entry = fn->getEntryBlock();
+    IRBuilder<> entry_builder(&entry, entry.begin());
+    buf = entry_builder.CreateAlloca(ArrayType::get(c_ty, num_elts));
+    builder_->CreateLifetimeStart(buf, size);
   }
+  else
+    buf = call(mod_->getOrInsertFunction("malloc", i8_ptr_ty, builder_->getInt64Ty()), {size});
+  Value *buf_a = bit_cast(buf, c_ty->getPointerTo());
+  Value *buf_b = gep(buf_a, i32(M*K));
+  Value *buf_c = gep(buf_a, i32(M*K + K*N));
+  auto to_c_ty = [&](Value *x) { return x->getType() == c_ty ? x : fpcast(x, c_ty); };
+  // spill: A is (M, K) row-major, B is (K, N) row-major, C is (M, N) row-major
+  auto pos_a = positions(A);
+  for(const indices_t& idx: get_idxs(A))
+    store(to_c_ty(vals_[A][idx]), gep(buf_a, i32(pos_a[0].at(idx[0])*K + pos_a[1].at(idx[1]))));
+  auto pos_b = positions(B);
+  for(const indices_t& idx: get_idxs(B))
+    store(to_c_ty(vals_[B][idx]), gep(buf_b, i32(pos_b[0].at(idx[0])*N + pos_b[1].at(idx[1]))));
+  auto pos_c = positions(C);
+  for(const indices_t& idx: get_idxs(C))
+    store(vals_[D][idx], gep(buf_c, i32(pos_c[0].at(idx[0])*N + pos_c[1].at(idx[1]))));
+  // helpers
+  Type *v_ty = W > 1 ? vec_ty(c_ty, W) : c_ty;
+  Function *f_mul_add = Intrinsic::getDeclaration(mod_, Intrinsic::fmuladd, std::vector<llvm::Type*>{v_ty});
+  unsigned elt_align = c_ty->getScalarSizeInBits() / 8;
+  auto vload = [&](Value *ptr, Value *off) -> Value* {
+    LoadInst *result = load(bit_cast(gep(ptr, off), v_ty->getPointerTo()));
+    result->setAlignment(Align(elt_align));
+    return result;
+  };
+  auto vstore = [&](Value *val, Value *ptr, Value *off) {
+    StoreInst *result = store(val, bit_cast(gep(ptr, off), v_ty->getPointerTo()));
+    result->setAlignment(Align(elt_align));
+  };
+  // emits a counted loop; `body` returns the loop-carried values
+  typedef std::vector<Value*> carried_t;
+  auto loop = [&](unsigned end, unsigned step, const carried_t& init,
+                  const std::function<carried_t(Value*, const carried_t&)>& body) {
+    BasicBlock *pre = builder_->GetInsertBlock();
+    BasicBlock *header = BasicBlock::Create(*ctx_, "dot_loop", fn);
+    BasicBlock *exit = BasicBlock::Create(*ctx_, "dot_loop_exit", fn);
+    br(header);
+    builder_->SetInsertPoint(header);
+    PHINode *iv = phi(i32_ty, 2);
+    iv->addIncoming(i32(0), pre);
+    carried_t phis;
+    for(Value *x: init){
+      PHINode *p = phi(x->getType(), 2);
+      p->addIncoming(x, pre);
+      phis.push_back(p);
+    }
+    carried_t next = body(iv, phis);
+    BasicBlock *latch = builder_->GetInsertBlock();
+    Value *next_iv = add(iv, i32(step));
+    iv->addIncoming(next_iv, latch);
+    for(size_t i = 0; i < phis.size(); i++)
+      ((PHINode*)phis[i])->addIncoming(next[i], latch);
+    cond_br(icmp_ult(next_iv, i32(end)), header, exit);
+    builder_->SetInsertPoint(exit);
+    return next;
+  };
+  // loop nest
+  loop(M, MR, {}, [&](Value *m0, const carried_t&) {
+    loop(N, NR*W, {}, [&](Value *n0, const carried_t&) {
+      carried_t acc;
+      for(unsigned i = 0; i < MR; i++)
+      for(unsigned j = 0; j < NR; j++)
+        acc.push_back(vload(buf_c, add(mul(add(m0, i32(i)), i32(N)), add(n0, i32(j*W)))));
+      acc = loop(K, 1, acc, [&](Value *k, const carried_t& acc) {
+        carried_t next(acc.size());
+        std::vector<Value*> b(NR);
+        for(unsigned j = 0; j < NR; j++)
+          b[j] = vload(buf_b, add(mul(k, i32(N)), add(n0, i32(j*W))));
+        for(unsigned i = 0; i < MR; i++){
+          Value *a = load(gep(buf_a, add(mul(add(m0, i32(i)), i32(K)), k)));
+          if(W > 1)
+            a = splat(W, a);
+          for(unsigned j = 0; j < NR; j++)
+            next[i*NR + j] = call(f_mul_add, {a, b[j], acc[i*NR + j]});
+        }
+        return next;
+      });
+      for(unsigned i = 0; i < MR; i++)
+      for(unsigned j = 0; j < NR; j++)
+        vstore(acc[i*NR + j], buf_c, add(mul(add(m0, i32(i)), i32(N)), add(n0, i32(j*W))));
+      return carried_t();
+    });
+    return carried_t();
+  });
+  // read back
+  for(const indices_t& idx: get_idxs(C))
+    vals_[C][idx] = load(gep(buf_c, i32(pos_c[0].at(idx[0])*N + pos_c[1].at(idx[1]))));
+  if(on_stack)
+    builder_->CreateLifetimeEnd(buf, size);
+  else
+    call(mod_->getOrInsertFunction("free", void_ty, i8_ptr_ty), {buf});
 }
 
 /**
@@ -1166,6 +1421,8 @@ void generator::visit_dot_inst(ir::dot_inst* dot) {
   unsigned NK = A_shapes[red_axis];
   bool is_outer = NK == 1;
   bool is_mma = layouts_->get(dot)->to_mma();
+  if(!tgt_->is_gpu())
+    return visit_cpudot(dot, A, B, D, NK, c_ty);
   if(!is_outer && is_mma && tgt_->as_nvidia()->sm() < 80)
     return visit_mma884(dot, A, B, D, NK);
   if(!is_outer && is_mma && tgt_->as_nvidia()->sm() >= 80)
@@ -1181,7 +1438,7 @@ void generator::visit_trans_inst(ir::trans_inst* trans) {
  * \brief Code Generation for `sqrt`
  */
 void generator::visit_sqrt_inst(ir::sqrt_inst* x) {
-  for(indices_t idx: idxs_.at(x)){
+  for(const indices_t& idx: get_idxs(x)){
     Value *val = vals_[x->get_operand(0)][idx];
     Value *ret = intrinsic(Intrinsic::sqrt, {val->getType()}, {val});
     vals_[x][idx] = ret;
@@ -1211,7 +1468,7 @@ void generator::visit_reduce1d_inst(ir::reduce_inst* x, std::function<Value*(Val
   Value *acc = nullptr;
 
   // reduce within thread
-  for(indices_t idx: idxs_.at(arg)){
+  for(const indices_t& idx: get_idxs(arg)){
     Value *val = vals_[arg][idx];
     acc = !acc ? val : do_acc(acc, val);
   }
@@ -1248,7 +1505,7 @@ void generator::visit_reduce1d_inst(ir::reduce_inst* x, std::function<Value*(Val
   // store first warp done
   builder_->SetInsertPoint(barrier->getParent());
   ret = load(base);
-  for(indices_t idx: idxs_.at(x))
+  for(const indices_t& idx: get_idxs(x))
     vals_[x][idx] = ret;
 }
 
@@ -1262,7 +1519,7 @@ void generator::visit_reducend_inst(ir::reduce_inst* x, std::function<Value*(Val
 
   // reduce within thread
   std::map<indices_t, Value*> accs;
-  for(indices_t idx: idxs_.at(arg)){
+  for(const indices_t& idx: get_idxs(arg)){
     indices_t pidx = idx;
     pidx[axis] = i32(0);
     Value *current = vals_[arg][idx];
@@ -1306,7 +1563,7 @@ void generator::visit_reducend_inst(ir::reduce_inst* x, std::function<Value*(Val
   add_barrier();
 
   // write back
-  for(indices_t idx: idxs_.at(x)){
+  for(const indices_t& idx: get_idxs(x)){
     indices_t read_idx = idx;
     read_idx.insert(read_idx.begin() + axis, i32(0));
     Value *read_off = shared_off(shape, order, read_idx);
@@ -1315,6 +1572,76 @@ void generator::visit_reducend_inst(ir::reduce_inst* x, std::function<Value*(Val
   };
 }
 
+/**
+ * \brief Code Generation for `reduce` (host case)
+ * A host thread owns the whole reduced axis: values are packed into
+ * SIMD vectors, combined pairwise, and finished with a single
+ * horizontal `llvm.vector.reduce`
+ */
+void generator::visit_reduce_cpu_inst(ir::reduce_inst* x, std::function<Value*(Value*,Value*)> do_acc) {
+  ir::value *arg = x->get_operand(0);
+  Type *ty = cvt(x->get_type()->get_scalar_ty());
+  unsigned axis = x->get_axis();
+  ir::reduce_inst::op_t op = x->get_op();
+  // values contributing to each output element
+  std::map<indices_t, std::vector<Value*>> groups;
+  for(const indices_t& idx: get_idxs(arg)){
+    indices_t pidx = idx;
+    pidx.erase(pidx.begin() + axis);
+    groups[pidx].push_back(vals_[arg][idx]);
+  }
+  // horizontal reduction
+  auto do_reduce = [&](Value *vec) -> Value* {
+    switch(op){
+    case ir::reduce_inst::ADD: return builder_->CreateAddReduce(vec);
+    case ir::reduce_inst::MAX: return builder_->CreateIntMaxReduce(vec, true);
+    case ir::reduce_inst::MIN: return builder_->CreateIntMinReduce(vec, true);
+    case ir::reduce_inst::FMAX: return builder_->CreateFPMaxReduce(vec);
+    case ir::reduce_inst::FMIN: return builder_->CreateFPMinReduce(vec);
+    case ir::reduce_inst::FADD: {
+      CallInst *ret = builder_->CreateFAddReduce(ConstantFP::get(ty, -0.0), vec);
+      ret->setHasAllowReassoc(true);
+      return ret;
+    }
+    default: throw std::runtime_error("unreachable");
+    }
+  };
+  // subtractions are not associative
+  bool is_assoc = op != ir::reduce_inst::SUB && op != ir::reduce_inst::FSUB;
+  size_t lanes = std::max<size_t>(tgt_->vector_bits() / ty->getScalarSizeInBits(), 1);
+  for(auto& g: groups){
+    std::vector<Value*>& vals = g.second;
+    size_t vec = is_assoc ? lanes : 1;
+    while(vec > 1 && vals.size() % vec != 0)
+      vec /= 2;
+    Value *ret = nullptr;
+    if(vec == 1){
+      for(Value *val: vals)
+        ret = !ret ? val : do_acc(ret, val);
+    }
+    else{
+      std::vector<Value*> packed;
+      for(size_t i = 0; i < vals.size(); i += vec){
+        Value *current = UndefValue::get(vec_ty(ty, vec));
+        for(size_t ii = 0; ii < vec; ii++)
+          current = insert_elt(current, vals[i + ii], ii);
+        packed.push_back(current);
+      }
+      // tree-shaped vertical reduction
+      while(packed.size() > 1){
+        std::vector<Value*> next;
+        for(size_t i = 0; i + 1 < packed.size(); i += 2)
+          next.push_back(do_acc(packed[i], packed[i + 1]));
+        if(packed.size() % 2)
+          next.push_back(packed.back());
+        packed = next;
+      }
+      ret = do_reduce(packed[0]);
+    }
+    vals_[x][g.first] = ret;
+  }
+}
+
 /**
  * \brief Code Generation for `reduce` (generic case)
  */
@@ -1349,7 +1676,9 @@ void generator::visit_reduce_inst(ir::reduce_inst* x) {
     default: throw std::runtime_error("unreachable");
   }
   ir::value *arg = x->get_operand(0);
-  if(arg->get_type()->get_tile_rank() == 1)
+  if(!tgt_->is_gpu())
+    visit_reduce_cpu_inst(x, do_acc);
+  else if(arg->get_type()->get_tile_rank() == 1)
     visit_reduce1d_inst(x, do_acc, neutral);
   else
     visit_reducend_inst(x, do_acc, neutral);
@@ -1359,10 +1688,13 @@ void generator::visit_reduce_inst(ir::reduce_inst* x) {
  * \brief Code Generation for `select`
  */
 void generator::visit_select_inst(ir::select_inst* x) {
-  for(indices_t idx: idxs_.at(x))
-    vals_[x][idx] = select(vals_[x->get_operand(0)][idx],
-                           vals_[x->get_operand(1)][idx],
-                           vals_[x->get_operand(2)][idx]);
+  tile_vals_t& dst = vals_[x];
+  const tile_idx_t* idx = dst.index();
+  tile_vals_t& pred = vals_[x->get_operand(0)];
+  tile_vals_t& if_value = vals_[x->get_operand(1)];
+  tile_vals_t& else_value = vals_[x->get_operand(2)];
+  for(size_t i = 0; i < dst.size(); i++)
+    dst[i] = select(pred.at(idx, i), if_value.at(idx, i), else_value.at(idx, i));
 }
 
 /**
@@ -1437,7 +1769,7 @@ void generator::visit_masked_load_async_inst(ir::masked_load_async_inst* x){
   int n_shared = std::max<int>(8 / in_layout->mts(in_order[1]), 1);
   std::vector<Value*> shared;
   for(size_t i = 0; i < n_shared; i++){
-    indices_t idx = idxs_.at(ptrs).at(i*per_thread_ld);
+    indices_t idx = get_idxs(ptrs).at(i*per_thread_ld);
     // phase
     Value* phase = udiv(idx[in_order[1]], i32(num_per_phase));
     phase = urem(phase, max_phase);
@@ -1452,8 +1784,8 @@ void generator::visit_masked_load_async_inst(ir::masked_load_async_inst* x){
     shared.push_back(gep(shmems_[x], {off}));
   }
   //
-  for(size_t i = 0; i < idxs_.at(ptrs).size(); i += vector){
-    auto idx = idxs_[ptrs][i];
+  for(size_t i = 0; i < get_idxs(ptrs).size(); i += vector){
+    auto idx = get_idxs(ptrs)[i];
     // input ptr info
     GetElementPtrInst *in_gep = dyn_cast<GetElementPtrInst>(vals_[ptrs][idx]);
     Value *in_base = in_gep->getPointerOperand();
@@ -1499,8 +1831,8 @@ void generator::visit_copy_to_shared_inst(ir::copy_to_shared_inst* cts) {
   // default implementation
   Value *current = nullptr;
   std::map<std::pair<int, int>, Value*> ptrs;
-  for(int i = 0; i < idxs_.at(arg).size(); i++){
-    auto idx = idxs_[arg][i];
+  for(int i = 0; i < get_idxs(arg).size(); i++){
+    auto idx = get_idxs(arg)[i];
     Value *in_value = vals_[arg][idx];
     if(i % min_vec == 0)
       current = UndefValue::get(vec_ty(in_value->getType(), min_vec));
@@ -1516,7 +1848,7 @@ void generator::visit_copy_to_shared_inst(ir::copy_to_shared_inst* cts) {
       std::pair<int, int> key = {id_1  % n_shared_1, id_0 % n_shared_0};
       if(ptrs.find(key) == ptrs.end()){
         builder_->SetInsertPoint(FirstBB->getTerminator());
-        indices_t idx = idxs_.at(arg).at(key.first*in_ld);
+        indices_t idx = get_idxs(arg).at(key.first*in_ld);
         Value* phase = udiv(idx[in_order[1]], i32(per_phase));
         phase = urem(phase, i32(max_phase));
         Value* off_1 = mul(idx[in_order[1]], i32(shapes[in_order[0]]));
@@ -1557,7 +1889,7 @@ void generator::visit_async_wait_inst(ir::async_wait_inst*) {
 }
 
 void generator::visit_make_range_dyn(ir::make_range_dyn* x) {
-  for(indices_t idx: idxs_.at(x)){
+  for(const indices_t& idx: get_idxs(x)){
     assert(idx.size() == 1);
     if(idx[0] == i32(0))
       vals_[x][idx] = idx[0];
@@ -1570,7 +1902,7 @@ void generator::visit_make_range_dyn(ir::make_range_dyn* x) {
 }
 
 void generator::visit_make_range_sta(ir::make_range_sta* x) {
-  for(indices_t idx: idxs_.at(x)){
+  for(const indices_t& idx: get_idxs(x)){
     assert(idx.size() == 1);
     if(idx[0] == i32(0)){
       vals_[x][idx] = idx[0];
@@ -1586,7 +1918,7 @@ void generator::visit_make_range_sta(ir::make_range_sta* x) {
 }
 
 void generator::visit_make_range(ir::make_range* x) {
-  for(indices_t idx: idxs_.at(x)){
+  for(const indices_t& idx: get_idxs(x)){
     vals_[x][idx] = idx[0];
   }
 }
@@ -1625,9 +1957,9 @@ void generator::visit_function(ir::function* fn) {
     std::vector<Type*> fn_args_ty;
     for(unsigned i = 0; i < fn_ty->getNumParams(); i++)
       fn_args_ty.push_back(fn_ty->getParamType(i));
-    fn_args_ty.push_back(i32_ty);
-    fn_args_ty.push_back(i32_ty);
-    fn_args_ty.push_back(i32_ty);
+    // program ids and grid size
+    for(unsigned i = 0; i < 6; i++)
+      fn_args_ty.push_back(i32_ty);
     fn_ty = FunctionType::get(fn_ret_ty, fn_args_ty, false);
   }
   Function *ret = Function::Create(fn_ty, Function::ExternalLinkage, fn->get_name(), mod_);
@@ -1872,31 +2204,26 @@ void generator::visit_argument(ir::argument* arg) {
 
 }
 
+const tile_idx_t* tile_vals_t::scalar_idx() {
+  static tile_idx_t result = {{indices_t()}, {{indices_t(), 0}}};
+  return &result;
+}
+
 void generator::init_idx(ir::value *v) {
-  idxs_[v].clear();
+  static const tile_idx_t empty;
   if(!v->get_type()->is_tile_ty()){
-    idxs_[v].push_back({});
+    vals_[v].init(tile_vals_t::scalar_idx());
     return;
   }
-  if(layouts_->get(v)->to_shared())
+  analysis::data_layout* layout = layouts_->get(v);
+  if(layout->to_shared()){
+    vals_[v].init(&empty);
     return;
+  }
   const auto &shapes = v->get_type()->get_tile_shapes();
   size_t rank = shapes.size();
-  std::vector<distributed_axis> axes(rank);
   std::vector<int> ord(rank);
-  // compute axes
-  for(size_t d = 0; d < shapes.size(); d++){
-    if(shapes[d] > 1){
-      unsigned x = a_axes_->get(v, d);
-      axes[d] = axes_.at(x);
-    }
-    else{
-      axes[d].contiguous = 1;
-      axes[d].values = {i32(0)};
-    }
-  }
   // compute order
-  analysis::data_layout* layout = layouts_->get(v);
   std::iota(ord.begin(), ord.end(), 0);
   auto cmp = [&](int x, int y) {
     unsigned axx = a_axes_->get(v, x);
@@ -1909,10 +2236,32 @@ void generator::init_idx(ir::value *v) {
   };
   std::sort(ord.begin(), ord.end(), cmp);
   ords_[v] = ord;
+  // indices only depend on the axis of each dimension
+  std::vector<int> key(rank, -1);
+  for(size_t d = 0; d < rank; d++)
+    if(shapes[d] > 1)
+      key[d] = a_axes_->get(v, d);
+  std::unique_ptr<tile_idx_t>& entry = tile_idxs_[{layout, key}];
+  if(entry){
+    vals_[v].init(entry.get());
+    return;
+  }
+  entry.reset(new tile_idx_t());
+  std::vector<indices_t>& idxs = entry->idxs;
+  // compute axes
+  std::vector<distributed_axis> axes(rank);
+  for(size_t d = 0; d < rank; d++){
+    if(shapes[d] > 1)
+      axes[d] = axes_.at(key[d]);
+    else{
+      axes[d].contiguous = 1;
+      axes[d].values = {i32(0)};
+    }
+  }
   // indices
   if(axes.size() == 1)
     for(Value* x0: axes[ord[0]].values){
-      idxs_[v].push_back({x0});
+      idxs.push_back({x0});
     }
   if(axes.size() == 2)
     for(Value* x1: axes[ord[1]].values)
@@ -1920,7 +2269,7 @@ void generator::init_idx(ir::value *v) {
       indices_t idx(2);
       idx[ord[0]] = x0;
       idx[ord[1]] = x1;
-      idxs_[v].push_back(idx);
+      idxs.push_back(idx);
     }
   if(axes.size() == 3)
     for(Value* x2: axes[ord[2]].values)
@@ -1930,8 +2279,11 @@ void generator::init_idx(ir::value *v) {
       idx[ord[0]] = x0;
       idx[ord[1]] = x1;
       idx[ord[2]] = x2;
-      idxs_[v].push_back(idx);
+      idxs.push_back(idx);
     }
+  for(size_t i = 0; i < idxs.size(); i++)
+    entry->pos[idxs[i]] = i;
+  vals_[v].init(entry.get());
 }
 
 void generator::finalize_shared_layout(analysis::shared_layout *shared) {
@@ -1976,11 +2328,10 @@ void generator::finalize_phi_node(ir::phi_node *x) {
   for(unsigned n = 0; n < x->get_num_incoming(); n++){
     ir::basic_block *_block = x->get_incoming_block(n);
     BasicBlock *block = bbs_.at(_block);
-    for(indices_t idx: idxs_.at(x)){
-      PHINode *phi = (PHINode*)vals_[x][idx];
-      Value *inc = vals_[x->get_incoming_value(n)][idx];
-      phi->addIncoming(inc, block);
-    }
+    tile_vals_t& phis = vals_[x];
+    tile_vals_t& incs = vals_[x->get_incoming_value(n)];
+    for(size_t i = 0; i < phis.size(); i++)
+      ((PHINode*)phis[i])->addIncoming(incs.at(phis.index(), i), block);
   }
 }
 
@@ -144,19 +144,17 @@ Instruction* cpu_target::add_memfence(Module *module, IRBuilder<>& builder) {
 }
 
 
+// host kernels take (..., pid_x, pid_y, pid_z, num_x, num_y, num_z)
 Value* cpu_target::get_block_id(Module *module, llvm::IRBuilder<> &builder, unsigned ax) {
   const Function *fn = builder.GetInsertBlock()->getParent();
   size_t num_params = fn->getFunctionType()->getNumParams();
-  static std::array<const Argument*, 3> ids = {
-    fn->arg_begin() + num_params - 3,
-    fn->arg_begin() + num_params - 2,
-    fn->arg_begin() + num_params - 1
-  };
-  return (Argument*)ids[ax];
+  return (Argument*)(fn->arg_begin() + num_params - 6 + ax);
 }
 
 Value* cpu_target::get_num_blocks(Module *module, IRBuilder<>& builder, unsigned ax) {
-  throw std::runtime_error("not implemented");
+  const Function *fn = builder.GetInsertBlock()->getParent();
+  size_t num_params = fn->getFunctionType()->getNumParams();
+  return (Argument*)(fn->arg_begin() + num_params - 3 + ax);
 }
 
 
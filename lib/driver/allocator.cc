@@ -0,0 +1,320 @@
+/* Copyright 2015-2017 Philippe Tillet
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files
+* (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge,
+* publish, distribute, sublicense, and/or sell copies of the Software,
+* and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdlib>
+#include <new>
+#include <set>
+#include <string>
+#include <sys/mman.h>
+#include "triton/driver/allocator.h"
+#include "triton/driver/stream.h"
+#include "triton/driver/dispatch.h"
+#include "triton/driver/error.h"
+
+namespace triton
+{
+
+namespace driver
+{
+
+/* ------------------------ */
+//         Base             //
+/* ------------------------ */
+
+// Host memory is 64-byte aligned, and page aligned from one page on.
+// From 2 MB on it is mapped directly, aligned to 2 MB and advised to be
+// backed by transparent huge pages (unless TRITON_HUGE_PAGES=0). Such
+// buffers are first touched by the workers of `stream`, with the same
+// partition as kernel launches, so that pages land on the NUMA node of
+// the worker that will process them.
+static const size_t host_page_size = 4096;
+static const size_t host_huge_page_size = 2 << 20;
+
+static bool use_huge_pages() {
+  static const char* env = std::getenv("TRITON_HUGE_PAGES");
+  return !env || std::string(env) != "0";
+}
+
+static size_t host_mapped_size(size_t size) {
+  return (size + host_huge_page_size - 1) / host_huge_page_size * host_huge_page_size;
+}
+
+static char* host_allocate(size_t size, driver::stream* stream) {
+  if(size < host_huge_page_size){
+    void* ptr = nullptr;
+    size_t align = size < host_page_size ? 64 : host_page_size;
+    if(posix_memalign(&ptr, align, size) != 0)
+      throw std::bad_alloc();
+    return (char*)ptr;
+  }
+  // over-map so that the start can be aligned to a huge page
+  size_t nbytes = host_mapped_size(size);
+  size_t mapped = nbytes + host_huge_page_size;
+  char* base = (char*)mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(base == MAP_FAILED)
+    throw std::bad_alloc();
+  char* ptr = (char*)(((uintptr_t)base + host_huge_page_size - 1) / host_huge_page_size * host_huge_page_size);
+  if(ptr > base)
+    munmap(base, ptr - base);
+  munmap(ptr + nbytes, base + mapped - (ptr + nbytes));
+#ifdef MADV_HUGEPAGE
+  if(use_huge_pages())
+    madvise(ptr, nbytes, MADV_HUGEPAGE);
+#endif
+  if(stream)
+    ((host_stream*)stream)->first_touch(ptr, nbytes, use_huge_pages() ? host_huge_page_size : host_page_size);
+  return ptr;
+}
+
+static void host_release(char* ptr, size_t size) {
+  if(size < host_huge_page_size)
+    free(ptr);
+  else
+    munmap(ptr, host_mapped_size(size));
+}
+
+uintptr_t allocator::raw_allocate(size_t size, driver::stream* stream) {
+  switch(backend_){
+    case CUDA: {
+      CUdeviceptr ptr;
+      dispatch::cuMemAlloc(&ptr, size);
+      return ptr;
+    }
+    case Host: return (uintptr_t)host_allocate(size, stream);
+    default: throw std::runtime_error("unknown backend");
+  }
+}
+
+void allocator::raw_release(uintptr_t ptr, size_t size) {
+  switch(backend_){
+    case CUDA: dispatch::cuMemFree((CUdeviceptr)ptr); break;
+    case Host: host_release((char*)ptr, size); break;
+    default: throw std::runtime_error("unknown backend");
+  }
+}
+
+static std::mutex allocators_mutex;
+static std::map<backend_t, std::shared_ptr<allocator>> allocators;
+
+std::shared_ptr<allocator> allocator::get(backend_t backend) {
+  std::lock_guard<std::mutex> lock(allocators_mutex);
+  std::shared_ptr<allocator>& result = allocators[backend];
+  if(!result)
+    result.reset(new caching_allocator(backend));
+  return result;
+}
+
+// buffers keep the allocator they were created with
+void allocator::set(backend_t backend, std::shared_ptr<allocator> alloc) {
+  if(alloc && alloc->backend() != backend)
+    throw std::runtime_error("allocator does not match backend");
+  std::lock_guard<std::mutex> lock(allocators_mutex);
+  allocators[backend] = alloc;
+}
+
+// every live caching allocator, including those replaced by `set` but still
+// used by buffers. never destroyed, since streams may outlive static objects
+static std::mutex& caching_allocators_mutex() {
+  static std::mutex* ret = new std::mutex();
+  return *ret;
+}
+
+static std::set<caching_allocator*>& caching_allocators() {
+  static std::set<caching_allocator*>* ret = new std::set<caching_allocator*>();
+  return *ret;
+}
+
+void allocator::forget(driver::stream* stream) {
+  std::lock_guard<std::mutex> lock(caching_allocators_mutex());
+  for(caching_allocator* alloc: caching_allocators())
+    alloc->forget_stream(stream);
+}
+
+/* ------------------------ */
+//         Direct           //
+/* ------------------------ */
+
+uintptr_t direct_allocator::allocate(size_t size, driver::stream* stream) {
+  uintptr_t ptr = raw_allocate(size, stream);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.num_allocs++;
+  stats_.in_use += size;
+  stats_.high_watermark = std::max(stats_.high_watermark, stats_.in_use);
+  return ptr;
+}
+
+void direct_allocator::release(uintptr_t ptr, size_t size, driver::stream*) {
+  raw_release(ptr, size);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.in_use -= size;
+}
+
+allocator::stats_t direct_allocator::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+/* ------------------------ */
+//         Caching          //
+/* ------------------------ */
+
+caching_allocator::caching_allocator(backend_t backend): allocator(backend) {
+  std::lock_guard<std::mutex> lock(caching_allocators_mutex());
+  caching_allocators().insert(this);
+}
+
+caching_allocator::~caching_allocator() {
+  std::lock_guard<std::mutex> lock(caching_allocators_mutex());
+  caching_allocators().erase(this);
+}
+
+size_t caching_allocator::size_class(size_t size) {
+  const size_t min_size = 512;
+  if(size <= min_size)
+    return min_size;
+  size_t base = min_size;
+  while(base*2 < size)
+    base *= 2;
+  size_t step = base / 4;
+  return (size + step - 1) / step * step;
+}
+
+bool caching_allocator::pop(const bin_key_t& key, uintptr_t& ptr) {
+  auto it = bins_.find(key);
+  if(it == bins_.end() || it->second.empty())
+    return false;
+  ptr = it->second.back();
+  it->second.pop_back();
+  return true;
+}
+
+void caching_allocator::synchronize_unordered() {
+  std::map<size_t, std::vector<uintptr_t>> unordered;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unordered.swap(unordered_);
+  }
+  dispatch::cuCtxSynchronize();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for(auto& x: unordered){
+    std::vector<uintptr_t>& bin = bins_[{nullptr, x.first}];
+    bin.insert(bin.end(), x.second.begin(), x.second.end());
+  }
+}
+
+uintptr_t caching_allocator::allocate(size_t size, driver::stream* stream) {
+  size_t nbytes = size_class(size);
+  uintptr_t ptr;
+  for(bool synchronized = false; ; synchronized = true){
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if(!synchronized)
+        stats_.num_allocs++;
+      if(pop({stream, nbytes}, ptr) || (stream && pop({nullptr, nbytes}, ptr))){
+        stats_.num_hits++;
+        stats_.cached -= nbytes;
+        stats_.in_use += nbytes;
+        return ptr;
+      }
+      auto it = unordered_.find(nbytes);
+      if(synchronized || it == unordered_.end() || it->second.empty())
+        break;
+    }
+    // one synchronization makes every pending block reusable
+    synchronize_unordered();
+  }
+  // miss: give cached blocks back and retry once when out of memory
+  try{
+    ptr = raw_allocate(nbytes, stream);
+  }catch(const exception::cuda::out_of_memory&){
+    trim();
+    ptr = raw_allocate(nbytes, stream);
+  }catch(const std::bad_alloc&){
+    trim();
+    ptr = raw_allocate(nbytes, stream);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.in_use += nbytes;
+  stats_.high_watermark = std::max(stats_.high_watermark, stats_.in_use + stats_.cached);
+  return ptr;
+}
+
+void caching_allocator::release(uintptr_t ptr, size_t size, driver::stream* stream) {
+  size_t nbytes = size_class(size);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(!stream && backend_ == CUDA)
+    unordered_[nbytes].push_back(ptr);
+  else
+    bins_[{stream, nbytes}].push_back(ptr);
+  stats_.in_use -= nbytes;
+  stats_.cached += nbytes;
+}
+
+void caching_allocator::trim() {
+  std::lock_guard<std::mutex> trim_lock(trim_mutex_);
+  std::map<bin_key_t, std::vector<uintptr_t>> bins;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bins.swap(bins_);
+    // cuMemFree synchronizes
+    for(auto& x: unordered_){
+      std::vector<uintptr_t>& bin = bins[{nullptr, x.first}];
+      bin.insert(bin.end(), x.second.begin(), x.second.end());
+    }
+    unordered_.clear();
+    stats_.cached = 0;
+  }
+  // work submitted before the release may still use the blocks
+  std::set<driver::stream*> streams;
+  for(auto& x: bins)
+    if(x.first.first)
+      streams.insert(x.first.first);
+  for(driver::stream* s: streams)
+    s->synchronize();
+  for(auto& x: bins)
+  for(uintptr_t ptr: x.second)
+    raw_release(ptr, x.first.second);
+}
+
+// host streams finish their work before they are destroyed, so their blocks
+// can go to any stream. CUDA streams may not have (e.g. streams of torch,
+// which we do not own), so their blocks wait for the context to be synchronized
+void caching_allocator::forget_stream(driver::stream* stream) {
+  std::lock_guard<std::mutex> trim_lock(trim_mutex_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = bins_.lower_bound({stream, 0});
+  while(it != bins_.end() && it->first.first == stream){
+    size_t nbytes = it->first.second;
+    std::vector<uintptr_t>& dst = backend_ == CUDA ? unordered_[nbytes] : bins_[{nullptr, nbytes}];
+    dst.insert(dst.end(), it->second.begin(), it->second.end());
+    it = bins_.erase(it);
+  }
+}
+
+allocator::stats_t caching_allocator::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}
+
+}
@@ -36,10 +36,27 @@ namespace driver
 //
 
 buffer::buffer(size_t size, CUdeviceptr cu, bool take_ownership)
-  : polymorphic_resource(cu, take_ownership), size_(size) { }
+  : polymorphic_resource(cu, take_ownership), size_(size), stream_(nullptr) { }
 
 buffer::buffer(size_t size, host_buffer_t hst, bool take_ownership)
-  : polymorphic_resource(hst, take_ownership), size_(size) { }
+  : polymorphic_resource(hst, take_ownership), size_(size), stream_(nullptr) { }
+
+buffer::~buffer() {
+  if(alloc_)
+    alloc_->release(addr_as_uintptr_t(), size_, stream_);
+}
+
+// the handle does not own memory obtained from the allocator
+void buffer::allocate(backend_t backend, driver::stream* stream) {
+  alloc_ = allocator::get(backend);
+  stream_ = stream;
+  uintptr_t ptr = alloc_->allocate(size_, stream_);
+  switch(backend){
+    case CUDA: *cu_ = ptr; break;
+    case Host: hst_->data = (char*)ptr; break;
+    default: throw std::runtime_error("unknown backend");
+  }
+}
 
 size_t buffer::size() {
   return size_;
@@ -54,27 +71,27 @@ uintptr_t buffer::addr_as_uintptr_t() {
 }
 
 
-buffer* buffer::create(driver::context* ctx, size_t size) {
+buffer* buffer::create(driver::context* ctx, size_t size, driver::stream* stream) {
   switch(ctx->backend()){
-  case CUDA: return new cu_buffer(size);
-  case Host: return new host_buffer(size);
+  case CUDA: return new cu_buffer(size, stream);
+  case Host: return new host_buffer(size, stream);
   default: throw std::runtime_error("unknown backend");
   }
 }
 
 //
 
-host_buffer::host_buffer(size_t size)
-  :  buffer(size, host_buffer_t(), true){
-  hst_->data = new char[size];
+host_buffer::host_buffer(size_t size, driver::stream* stream)
+  :  buffer(size, host_buffer_t(), false){
+  allocate(Host, stream);
 }
 
 
 //
 
-cu_buffer::cu_buffer(size_t size)
-  : buffer(size, CUdeviceptr(), true) {
-  dispatch::cuMemAlloc(&*cu_, size);
+cu_buffer::cu_buffer(size_t size, driver::stream* stream)
+  : buffer(size, CUdeviceptr(), false) {
+  allocate(CUDA, stream);
 }
 
 cu_buffer::cu_buffer(size_t size, CUdeviceptr cu, bool take_ownership)
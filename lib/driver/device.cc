@@ -28,6 +28,8 @@
 #include "triton/driver/device.h"
 #include "triton/driver/context.h"
 #include "triton/codegen/target.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
 
 namespace triton
 {
@@ -40,7 +42,16 @@ namespace driver
 /* ------------------------ */
 
 std::unique_ptr<codegen::target> host_device::make_target() const {
-  return std::unique_ptr<codegen::cpu_target>(new codegen::cpu_target());
+  // native SIMD width of the host
+  unsigned vector_bits = 128;
+  llvm::StringMap<bool> features;
+  if(llvm::sys::getHostCPUFeatures(features)){
+    if(features.lookup("avx512f"))
+      vector_bits = 512;
+    else if(features.lookup("avx2"))
+      vector_bits = 256;
+  }
+  return std::unique_ptr<codegen::cpu_target>(new codegen::cpu_target(vector_bits));
 }
 
 
@@ -73,6 +73,7 @@ namespace driver
 {return f_impl<dispatch::init>(hlib, fname, fname ## _, #fname, a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p, q, r, s); }
 
 //Specialized helpers for CUDA
+#define CUDA_DEFINE0(ret, fname) DEFINE0(cuinit, cuda_, ret, fname)
 #define CUDA_DEFINE1(ret, fname, t1) DEFINE1(cuinit, cuda_, ret, fname, t1)
 #define CUDA_DEFINE2(ret, fname, t1, t2) DEFINE2(cuinit, cuda_, ret, fname, t1, t2)
 #define CUDA_DEFINE3(ret, fname, t1, t2, t3) DEFINE3(cuinit, cuda_, ret, fname, t1, t2, t3)
@@ -129,6 +130,7 @@ bool dispatch::spvllvminit(){
 
 //CUDA
 CUDA_DEFINE1(CUresult, cuCtxDestroy_v2, CUcontext)
+CUDA_DEFINE0(CUresult, cuCtxSynchronize)
 CUDA_DEFINE2(CUresult, cuEventCreate, CUevent *, unsigned int)
 CUDA_DEFINE2(CUresult, cuDeviceGet, CUdevice *, int)
 CUDA_DEFINE3(CUresult, cuMemcpyDtoH_v2, void *, CUdeviceptr, size_t)
@@ -151,9 +153,12 @@ CUDA_DEFINE1(CUresult, cuDeviceGetCount, int *)
 CUDA_DEFINE3(CUresult, cuMemcpyHtoD_v2, CUdeviceptr, const void *, size_t )
 CUDA_DEFINE1(CUresult, cuInit, unsigned int)
 CUDA_DEFINE2(CUresult, cuEventRecord, CUevent, CUstream)
+CUDA_DEFINE1(CUresult, cuEventQuery, CUevent)
+CUDA_DEFINE1(CUresult, cuEventSynchronize, CUevent)
 CUDA_DEFINE3(CUresult, cuCtxCreate_v2, CUcontext *, unsigned int, CUdevice)
 CUDA_DEFINE3(CUresult, cuModuleGetFunction, CUfunction *, CUmodule, const char *)
 CUDA_DEFINE1(CUresult, cuStreamSynchronize, CUstream)
+CUDA_DEFINE3(CUresult, cuStreamWaitEvent, CUstream, CUevent, unsigned int)
 CUDA_DEFINE1(CUresult, cuStreamDestroy_v2, CUstream)
 CUDA_DEFINE2(CUresult, cuStreamGetCtx, CUstream, CUcontext*)
 CUDA_DEFINE1(CUresult, cuEventDestroy_v2, CUevent)
@@ -199,6 +204,7 @@ void* dispatch::spvllvm_;
 void* dispatch::cuCtxGetCurrent_;
 void* dispatch::cuCtxSetCurrent_;
 void* dispatch::cuCtxDestroy_v2_;
+void* dispatch::cuCtxSynchronize_;
 void* dispatch::cuEventCreate_;
 void* dispatch::cuDeviceGet_;
 void* dispatch::cuMemcpyDtoH_v2_;
@@ -221,9 +227,12 @@ void* dispatch::cuDeviceGetCount_;
 void* dispatch::cuMemcpyHtoD_v2_;
 void* dispatch::cuInit_;
 void* dispatch::cuEventRecord_;
+void* dispatch::cuEventQuery_;
+void* dispatch::cuEventSynchronize_;
 void* dispatch::cuCtxCreate_v2_;
 void* dispatch::cuModuleGetFunction_;
 void* dispatch::cuStreamSynchronize_;
+void* dispatch::cuStreamWaitEvent_;
 void* dispatch::cuStreamDestroy_v2_;
 void* dispatch::cuStreamGetCtx_;
 void* dispatch::cuEventDestroy_v2_;
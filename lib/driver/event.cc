@@ -0,0 +1,158 @@
+/* Copyright 2015-2017 Philippe Tillet
+* 
+* Permission is hereby granted, free of charge, to any person obtaining 
+* a copy of this software and associated documentation files 
+* (the "Software"), to deal in the Software without restriction, 
+* including without limitation the rights to use, copy, modify, merge, 
+* publish, distribute, sublicense, and/or sell copies of the Software, 
+* and to permit persons to whom the Software is furnished to do so, 
+* subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be 
+* included in all copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <stdexcept>
+#include "triton/driver/event.h"
+#include "triton/driver/stream.h"
+#include "triton/driver/error.h"
+
+namespace triton
+{
+
+namespace driver
+{
+
+/* ------------------------ */
+//         Base             //
+/* ------------------------ */
+
+event::event(CUevent cu, bool has_ownership)
+  : polymorphic_resource(cu, has_ownership) {
+}
+
+event::event(host_event_t hst, bool has_ownership)
+  : polymorphic_resource(hst, has_ownership) {
+}
+
+driver::event* event::create(backend_t backend) {
+  switch(backend){
+    case CUDA: return new cu_event();
+    case Host: return new host_event();
+    default: throw std::runtime_error("unknown backend");
+  }
+}
+
+/* ------------------------ */
+//          Host            //
+/* ------------------------ */
+
+host_event::host_event(): event(host_event_t(), true) {
+  hst_->state.reset(new host_event_state_t());
+}
+
+void host_event::record(driver::stream* stream) {
+  if(stream->backend() != Host)
+    throw std::runtime_error("host events can only be recorded on host streams");
+  std::shared_ptr<host_event_state_t> state = hst_->state;
+  uint64_t id;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    id = ++state->recorded;
+  }
+  ((host_stream*)stream)->submit([state, id](tools::work_stealing_pool::done_fn_t done) {
+    std::vector<std::function<void()>> ready;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      // records on different streams may retire out of order
+      if(state->retired.empty() || id > *state->retired.rbegin())
+        state->time = std::chrono::steady_clock::now();
+      state->retired.insert(id);
+      while(!state->retired.empty() && *state->retired.begin() == state->completed + 1){
+        state->retired.erase(state->retired.begin());
+        state->completed++;
+      }
+      // only the waiters of this record are released
+      auto range = state->waiters.equal_range(id);
+      for(auto it = range.first; it != range.second; ++it)
+        ready.push_back(std::move(it->second));
+      state->waiters.erase(range.first, range.second);
+      state->cv.notify_all();
+    }
+    for(auto& fn: ready)
+      fn();
+    done();
+  });
+}
+
+bool host_event::query() {
+  std::lock_guard<std::mutex> lock(hst_->state->mutex);
+  return hst_->state->has_retired(hst_->state->recorded);
+}
+
+void host_event::synchronize() {
+  host_event_state_t* state = &*hst_->state;
+  std::unique_lock<std::mutex> lock(state->mutex);
+  uint64_t id = state->recorded;
+  state->cv.wait(lock, [&]{ return state->has_retired(id); });
+}
+
+float host_event::elapsed_time(driver::event* start) {
+  if(start->backend() != Host)
+    throw std::runtime_error("cannot time a host event against a CUDA event");
+  if(!query() || !start->query())
+    throw std::runtime_error("events have not completed");
+  std::chrono::steady_clock::time_point begin, end;
+  {
+    std::lock_guard<std::mutex> lock(start->hst()->state->mutex);
+    begin = start->hst()->state->time;
+  }
+  {
+    std::lock_guard<std::mutex> lock(hst_->state->mutex);
+    end = hst_->state->time;
+  }
+  return std::chrono::duration<float, std::milli>(end - begin).count();
+}
+
+/* ------------------------ */
+//         CUDA             //
+/* ------------------------ */
+
+cu_event::cu_event(): event(CUevent(), true) {
+  dispatch::cuEventCreate(&*cu_, 0);
+}
+
+void cu_event::record(driver::stream* stream) {
+  dispatch::cuEventRecord(*cu_, *stream->cu());
+}
+
+bool cu_event::query() {
+  try{
+    dispatch::cuEventQuery(*cu_);
+  }catch(const exception::cuda::not_ready&){
+    return false;
+  }
+  return true;
+}
+
+void cu_event::synchronize() {
+  dispatch::cuEventSynchronize(*cu_);
+}
+
+float cu_event::elapsed_time(driver::event* start) {
+  float ret;
+  dispatch::cuEventElapsedTime(&ret, *start->cu(), *cu_);
+  return ret;
+}
+
+}
+
+}
@@ -34,9 +34,16 @@ inline void _delete(host_platform_t) { }
 inline void _delete(host_device_t)   { }
 inline void _delete(host_context_t)  { }
 inline void _delete(host_module_t)   { }
-inline void _delete(host_stream_t)   { }
+inline void _delete(host_stream_t x) {
+  // in-flight launches still reference the pool
+  if(!x.queue)
+    return;
+  std::unique_lock<std::mutex> lock(x.queue->mutex);
+  x.queue->cv.wait(lock, [&]{ return !x.queue->busy; });
+}
 inline void _delete(host_buffer_t x)   { if(x.data) delete[] x.data; }
 inline void _delete(host_function_t) { }
+inline void _delete(host_event_t) { }
 
 //CUDA
 inline void _delete(CUcontext x) { dispatch::cuCtxDestroy(x); }
@@ -73,6 +80,7 @@ template class handle<CUdeviceptr>;
 template class handle<CUstream>;
 template class handle<CUcontext>;
 template class handle<CUdevice>;
+template class handle<CUevent>;
 template class handle<cu_event_t>;
 template class handle<CUfunction>;
 template class handle<CUmodule>;
@@ -85,6 +93,7 @@ template class handle<host_module_t>;
 template class handle<host_stream_t>;
 template class handle<host_buffer_t>;
 template class handle<host_function_t>;
+template class handle<host_event_t>;
 
 
 }
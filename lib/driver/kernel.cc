@@ -23,6 +23,7 @@
 #include <string.h>
 #include "triton/driver/kernel.h"
 #include "triton/driver/buffer.h"
+#include "triton/driver/module.h"
 
 namespace triton
 {
@@ -61,7 +62,7 @@ driver::module* kernel::module() {
 /* ------------------------ */
 
 host_kernel::host_kernel(driver::module* program, const char *name): kernel(program, host_function_t(), true) {
-  hst_->fn = program->hst()->functions.at(name);
+  hst_->fn = ((driver::host_module*)program)->address(name);
 }
 
 /* ------------------------ */
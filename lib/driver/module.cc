@@ -20,8 +20,11 @@
 * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 #include <fstream>
+#include <dlfcn.h>
 #include <unistd.h>
 #include <memory>
+#include <mutex>
+#include <atomic>
 #include <regex>
 #include "triton/driver/module.h"
 #include "triton/driver/context.h"
@@ -36,10 +39,18 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Object/ObjectFile.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/IR/LegacyPassManager.h"
-#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/Core.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
@@ -66,15 +77,15 @@ namespace driver
 /* ------------------------ */
 
 void module::init_llvm() {
-  static bool init = false;
-  if(!init){
+  // modules may be compiled from several threads
+  static std::once_flag init;
+  std::call_once(init, [](){
     llvm::InitializeAllTargetInfos();
     llvm::InitializeAllTargets();
     llvm::InitializeAllTargetMCs();
     llvm::InitializeAllAsmParsers();
     llvm::InitializeAllAsmPrinters();
-    init = true;
-  }
+  });
 }
 
 module::module(CUmodule mod, bool has_ownership)
@@ -94,6 +105,14 @@ module* module::create(driver::device* device, std::unique_ptr<llvm::Module> src
   }
 }
 
+module* module::create(driver::device* device, const std::string& binary) {
+  switch(device->backend()){
+    case CUDA: return new cu_module(device, binary);
+    case Host: return new host_module(binary);
+    default: throw std::runtime_error("unknown backend");
+  }
+}
+
 void module::compile_llvm_module(std::unique_ptr<llvm::Module> module, const std::string& triple,
                                  const std::string &proc, std::string layout,
                                  llvm::SmallVectorImpl<char> &buffer,
@@ -116,8 +135,9 @@ void module::compile_llvm_module(std::unique_ptr<llvm::Module> module, const std
   opt.UnsafeFPMath = false;
   opt.NoInfsFPMath = false;
   opt.NoNaNsFPMath = true;
-  llvm::TargetMachine *machine = target->createTargetMachine(module->getTargetTriple(), proc, features, opt,
-                                                             llvm::Reloc::PIC_, llvm::None, llvm::CodeGenOpt::Aggressive);
+  // one target machine per call, so that modules can be lowered concurrently
+  std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(module->getTargetTriple(), proc, features, opt,
+                                                                           llvm::Reloc::PIC_, llvm::None, llvm::CodeGenOpt::Aggressive));
   // set data layout
   if(layout.empty())
     module->setDataLayout(machine->createDataLayout());
@@ -144,24 +164,52 @@ void module::compile_llvm_module(std::unique_ptr<llvm::Module> module, const std
 //        Host              //
 /* ------------------------ */
 
-host_module::host_module(std::unique_ptr<llvm::Module> src): module(host_module_t(), true) {
-  init_llvm();
-  // create kernel wrapper
-  llvm::LLVMContext &ctx = src->getContext();
+// Object code of all host modules is linked into a single
+// ORC session. Linking and symbol lookup are thread-safe,
+// so modules compiled on different threads can be loaded
+// concurrently without a global lock
+struct host_jit_t {
+  host_jit_t()
+#if LLVM_VERSION_MAJOR >= 13
+    : session(llvm::cantFail(llvm::orc::SelfExecutorProcessControl::Create())),
+#else
+    : session(),
+#endif
+      linker(session, [](){ return std::unique_ptr<llvm::SectionMemoryManager>(new llvm::SectionMemoryManager()); }),
+      layout(llvm::cantFail(llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost()).getDefaultDataLayoutForTarget())),
+      mangle(session, layout),
+      num_dylibs(0) { }
+
+  llvm::orc::ExecutionSession session;
+  llvm::orc::RTDyldObjectLinkingLayer linker;
+  llvm::DataLayout layout;
+  llvm::orc::MangleAndInterner mangle;
+  std::atomic<size_t> num_dylibs;
+};
+
+// never destroyed: kernels may outlive static destructors
+static host_jit_t& host_jit() {
+  static host_jit_t* jit = new host_jit_t();
+  return *jit;
+}
+
+void host_module::add_entry_point(llvm::Module& src, const std::string& name) {
+  llvm::LLVMContext &ctx = src.getContext();
   llvm::Type *void_ty = llvm::Type::getVoidTy(ctx);
   llvm::Type *args_ty = llvm::Type::getInt8PtrTy(ctx)->getPointerTo();
   llvm::Type *int32_ty = llvm::Type::getInt32Ty(ctx);
-  std::vector<llvm::Type*> tys = {args_ty, int32_ty, int32_ty, int32_ty};
+  std::vector<llvm::Type*> tys = {args_ty, int32_ty, int32_ty, int32_ty, int32_ty, int32_ty, int32_ty};
   llvm::FunctionType *main_ty = llvm::FunctionType::get(void_ty, tys, false);
-  llvm::Function* main = llvm::Function::Create(main_ty, llvm::Function::ExternalLinkage, "_main", &*src);
-  llvm::Function* fn = &*src->getFunctionList().begin();
+  llvm::Function* fn = &*src.getFunctionList().begin();
+  llvm::Function* main = llvm::Function::Create(main_ty, llvm::Function::ExternalLinkage, name, &src);
   llvm::FunctionType *fn_ty = fn->getFunctionType();
   std::vector<llvm::Value*> fn_args(fn_ty->getNumParams());
-  std::vector<llvm::Value*> ptrs(fn_args.size() - 3);
+  std::vector<llvm::Value*> ptrs(fn_args.size() - 6);
   llvm::BasicBlock* entry = llvm::BasicBlock::Create(ctx, "entry", main);
   llvm::IRBuilder<> ir_builder(ctx);
   ir_builder.SetInsertPoint(entry);
-  auto get_size = [](llvm::Type* ty) { return ty->isPointerTy() ? sizeof(char*) : ty->getPrimitiveSizeInBits() / 8; };
+  // booleans take one byte, as in runtime::size_of
+  auto get_size = [](llvm::Type* ty) { return ty->isPointerTy() ? sizeof(char*) : std::max<size_t>(ty->getPrimitiveSizeInBits() / 8, 1); };
   llvm::Value* base = main->arg_begin();
   llvm::Value* args_base = ir_builder.CreateBitCast(base, base->getType()->getPointerElementType());
 
@@ -180,45 +228,82 @@ host_module::host_module(std::unique_ptr<llvm::Module> src): module(host_module_
   for(unsigned i = 0; i < ptrs.size(); i++)
     fn_args[i] = ir_builder.CreateLoad(ptrs[i]);
 
-  fn_args[fn_args.size() - 3] = main->arg_begin() + 1;
-  fn_args[fn_args.size() - 2] = main->arg_begin() + 2;
-  fn_args[fn_args.size() - 1] = main->arg_begin() + 3;
+  // program ids and grid size
+  for(unsigned i = 0; i < 6; i++)
+    fn_args[fn_args.size() - 6 + i] = main->arg_begin() + 1 + i;
   ir_builder.CreateCall(fn, fn_args);
   ir_builder.CreateRetVoid();
+}
 
-//  llvm::legacy::PassManager pm;
-//  pm.add(llvm::createPrintModulePass(llvm::outs()));
-//  pm.add(llvm::createVerifierPass());
-//  pm.run(*src);
-
-//   create execution engine
-  for(llvm::Function& fn: src->functions())
-    hst_->functions[fn.getName().str()] = &fn;
-
-//  llvm::orc::JITTargetMachineBuilder JTMB = *llvm::orc::JITTargetMachineBuilder::detectHost();
-//  auto DL = JTMB.getDefaultDataLayoutForTarget();
-//  auto CIRC = std::unique_ptr<llvm::orc::ConcurrentIRCompiler>(new llvm::orc::ConcurrentIRCompiler(JTMB));
-//  hst_->ES = new llvm::orc::ExecutionSession();
-//  hst_->ObjectLayer = new llvm::orc::RTDyldObjectLinkingLayer(*hst_->ES, []() { return std::unique_ptr<llvm::SectionMemoryManager>(new llvm::SectionMemoryManager()); });
-//  hst_->CompileLayer = new llvm::orc::IRCompileLayer(*hst_->ES, *hst_->ObjectLayer, *CIRC);
-//  hst_->DL = new llvm::DataLayout(std::move(*DL));
-//  hst_->Mangle = new llvm::orc::MangleAndInterner(*hst_->ES, *hst_->DL);
-//  hst_->Ctx = new llvm::orc::ThreadSafeContext(std::unique_ptr<llvm::LLVMContext>(new llvm::LLVMContext()));
-//  hst_->MainJD =  &hst_->ES->createJITDylib("<main>");
-//  hst_->MainJD->setGenerator(llvm::cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
-//                                            hst_->DL->getGlobalPrefix())));
-//  llvm::cantFail(hst_->CompileLayer->add(*hst_->MainJD, llvm::orc::ThreadSafeModule(std::move(src), *hst_->Ctx)));
-//  hst_->fn = (void(*)(char**, int32_t, int32_t, int32_t))(hst_->ES->lookup({hst_->MainJD}, (*hst_->Mangle)("_main"))->getAddress());
-
-
-
-  llvm::EngineBuilder builder(std::move(src));
-  builder.setErrorStr(&hst_->error);
-  builder.setMCJITMemoryManager(std::make_unique<llvm::SectionMemoryManager>());
-  builder.setOptLevel(llvm::CodeGenOpt::Aggressive);
-  builder.setEngineKind(llvm::EngineKind::JIT);
-  hst_->engine = builder.create();
-  hst_->fn = (void(*)(char**, int32_t, int32_t, int32_t))(hst_->engine->getFunctionAddress("_main"));
+host_module::host_module(std::unique_ptr<llvm::Module> src): module(host_module_t(), true) {
+  init_llvm();
+  add_entry_point(*src, "_main");
+  // the LLVM context of `src` does not outlive this constructor,
+  // so the module is lowered to object code right away
+  obj_ = compile_llvm_module(std::move(src));
+  load(obj_);
+}
+
+host_module::host_module(const std::string& obj): module(host_module_t(), true), obj_(obj) {
+  init_llvm();
+  load(obj_);
+}
+
+host_module::host_module(void* lib, const std::string& entry): module(host_module_t(), true) {
+  hst_->dylib = nullptr;
+  hst_->lib = lib;
+  hst_->fn = (void(*)(char**, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t))(address(entry));
+}
+
+std::string host_module::compile_llvm_module(std::unique_ptr<llvm::Module> module,
+                                             const std::string& cpu, const std::string& features) {
+  std::string proc = cpu;
+  std::string attrs = features;
+  if(proc.empty()){
+    proc = llvm::sys::getHostCPUName().str();
+    llvm::StringMap<bool> host_features;
+    if(attrs.empty() && llvm::sys::getHostCPUFeatures(host_features))
+      for(auto& f: host_features)
+        attrs += (f.second ? "+" : "-") + f.first().str() + ",";
+  }
+  llvm::SmallVector<char, 0> buffer;
+  module::compile_llvm_module(std::move(module), llvm::sys::getProcessTriple(), proc,
+                              "", buffer, attrs, Object);
+  return std::string(buffer.begin(), buffer.end());
+}
+
+void host_module::load(const std::string& obj) {
+  host_jit_t& jit = host_jit();
+  // one dylib per module, so that every module can define `_main`
+  std::string name = "triton" + std::to_string(jit.num_dylibs++);
+  hst_->lib = nullptr;
+#if LLVM_VERSION_MAJOR >= 11
+  hst_->dylib = &jit.session.createBareJITDylib(name);
+#else
+  hst_->dylib = &jit.session.createJITDylib(name);
+#endif
+  // libm and friends are resolved from the host process
+  hst_->dylib->addGenerator(llvm::cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+                            jit.layout.getGlobalPrefix())));
+  // link object code
+  std::unique_ptr<llvm::MemoryBuffer> buffer = llvm::MemoryBuffer::getMemBufferCopy(obj, name);
+  if(llvm::Error err = jit.linker.add(*hst_->dylib, std::move(buffer)))
+    throw std::runtime_error("invalid host object code: " + llvm::toString(std::move(err)));
+  hst_->fn = (void(*)(char**, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t))(address("_main"));
+}
+
+void* host_module::address(const std::string& name) const {
+  if(hst_->lib){
+    void* ret = dlsym(hst_->lib, name.c_str());
+    if(!ret)
+      throw std::runtime_error("symbol " + name + " not found in host module: " + dlerror());
+    return ret;
+  }
+  host_jit_t& jit = host_jit();
+  auto sym = jit.session.lookup({hst_->dylib}, jit.mangle(name));
+  if(!sym)
+    throw std::runtime_error("symbol " + name + " not found in host module: " + llvm::toString(sym.takeError()));
+  return (void*)sym->getAddress();
 }
 
 std::unique_ptr<buffer> host_module::symbol(const char *name) const {
@@ -23,14 +23,19 @@
 #include <cassert>
 #include <unistd.h>
 #include <array>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include "triton/driver/allocator.h"
 #include "triton/driver/backend.h"
 #include "triton/driver/stream.h"
+#include "triton/driver/event.h"
 #include "triton/driver/context.h"
 #include "triton/driver/device.h"
 #include "triton/driver/kernel.h"
 #include "triton/driver/buffer.h"
-#include "llvm/ExecutionEngine/ExecutionEngine.h"
-#include "llvm/ExecutionEngine/GenericValue.h"
 
 namespace triton
 {
@@ -64,35 +69,345 @@ driver::stream* stream::create(backend_t backend) {
 //          Host            //
 /* ------------------------ */
 
+// runs programs [begin, end) of a launch
+static void run_programs(host_graph::fn_t fn, std::array<size_t, 3> grid, char** params, size_t begin, size_t end) {
+  for(size_t id = begin; id < end; id++){
+    size_t i = id % grid[0];
+    size_t j = (id / grid[0]) % grid[1];
+    size_t k = id / (grid[0]*grid[1]);
+    fn(params, int32_t(i), int32_t(j), int32_t(k), int32_t(grid[0]), int32_t(grid[1]), int32_t(grid[2]));
+  }
+}
+
+// allocation that contains `ptr`, if declared
+const void* host_graph::allocation_of(const void* ptr) const {
+  auto it = allocations_.upper_bound(ptr);
+  if(it == allocations_.begin())
+    return nullptr;
+  --it;
+  if((const char*)ptr >= (const char*)it->first + it->second)
+    return nullptr;
+  return it->first;
+}
+
+// a launch depends on the last previous launch that used each of the allocations
+// it points into; pointers may be offset views, so they are compared by allocation
+void host_graph::link() {
+  std::map<const void*, size_t> last;
+  // launches with unknown pointers are ordered with every other launch
+  size_t barrier = nodes_.size();
+  std::vector<size_t> since_barrier;
+  roots_.clear();
+  for(node_t& x: nodes_){
+    x.succs.clear();
+    x.num_preds = 0;
+  }
+  for(size_t i = 0; i < nodes_.size(); i++){
+    node_t& x = nodes_[i];
+    std::vector<const void*> allocs;
+    bool known = !x.ptr_offsets.empty();
+    for(size_t offset: x.ptr_offsets){
+      const void* ptr;
+      std::memcpy(&ptr, x.params.data() + offset, sizeof(ptr));
+      const void* alloc = allocation_of(ptr);
+      known = known && alloc;
+      allocs.push_back(alloc);
+    }
+    std::set<size_t> preds;
+    if(!known){
+      preds.insert(since_barrier.begin(), since_barrier.end());
+      if(barrier < nodes_.size())
+        preds.insert(barrier);
+      barrier = i;
+      since_barrier.clear();
+      last.clear();
+    }
+    else{
+      for(const void* alloc: allocs){
+        auto it = last.find(alloc);
+        if(it != last.end() && it->second != i)
+          preds.insert(it->second);
+        last[alloc] = i;
+      }
+      if(barrier < nodes_.size())
+        preds.insert(barrier);
+      since_barrier.push_back(i);
+    }
+    for(size_t p: preds)
+      nodes_[p].succs.push_back(i);
+    x.num_preds = preds.size();
+    if(preds.empty())
+      roots_.push_back(i);
+  }
+}
+
+// overlapping allocations are merged, so that every byte has one owner
+void host_graph::add_allocation(const void* base, size_t size) {
+  const char* lo = (const char*)base;
+  const char* hi = lo + size;
+  auto it = allocations_.upper_bound(base);
+  if(it != allocations_.begin() && (const char*)std::prev(it)->first + std::prev(it)->second > lo)
+    --it;
+  while(it != allocations_.end() && (const char*)it->first < hi){
+    lo = std::min(lo, (const char*)it->first);
+    hi = std::max(hi, (const char*)it->first + it->second);
+    it = allocations_.erase(it);
+  }
+  allocations_[lo] = hi - lo;
+  link();
+}
+
+void host_graph::add(node_t node) {
+  nodes_.push_back(std::move(node));
+}
+
+void host_graph::rebind(const void* from, const void* to) {
+  for(node_t& x: nodes_)
+    for(size_t offset: x.ptr_offsets){
+      char* dst = x.params.data() + offset;
+      if(std::memcmp(dst, &from, sizeof(from)) == 0)
+        std::memcpy(dst, &to, sizeof(to));
+    }
+  link();
+}
+
+// dependencies left, for every launch of a replay
+struct host_graph::replay_t {
+  std::unique_ptr<std::atomic<size_t>[]> num_preds;
+  std::atomic<size_t> num_pending;
+  tools::work_stealing_pool::done_fn_t done;
+};
+
+void host_graph::run(tools::work_stealing_pool* pool, std::shared_ptr<replay_t> replay, size_t i) {
+  const node_t& x = nodes_[i];
+  fn_t fn = x.fn;
+  std::array<size_t, 3> grid = x.grid;
+  char** params = (char**)x.params.data();
+  pool->parallel_for(grid[0]*grid[1]*grid[2], x.grain, [fn, grid, params](size_t begin, size_t end) {
+    run_programs(fn, grid, params, begin, end);
+  }, [this, pool, replay, i]() {
+    for(size_t j: nodes_[i].succs)
+      if(--replay->num_preds[j] == 0)
+        run(pool, replay, j);
+    if(--replay->num_pending == 0)
+      replay->done();
+  });
+}
+
+void host_graph::replay(tools::work_stealing_pool* pool, tools::work_stealing_pool::done_fn_t done) {
+  std::shared_ptr<replay_t> replay(new replay_t());
+  replay->num_preds.reset(new std::atomic<size_t>[nodes_.size()]);
+  for(size_t i = 0; i < nodes_.size(); i++)
+    replay->num_preds[i] = nodes_[i].num_preds;
+  replay->num_pending = nodes_.size();
+  replay->done = done;
+  for(size_t i: roots_)
+    run(pool, replay, i);
+}
+
+// streams share the cores rather than oversubscribe them
+static std::shared_ptr<tools::work_stealing_pool> host_pool() {
+  static std::shared_ptr<tools::work_stealing_pool> pool(new tools::work_stealing_pool(std::thread::hardware_concurrency()));
+  return pool;
+}
+
 host_stream::host_stream(): stream(host_stream_t(), true) {
-  hst_->pool.reset(new ThreadPool(1));
-  hst_->futures.reset(new std::vector<std::future<void>>());
+  hst_->pool = host_pool();
+  hst_->queue.reset(new host_stream_queue_t());
+}
+
+host_stream::~host_stream() {
+  host_stream_queue_t* queue = &*hst_->queue;
+  {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    queue->cv.wait(lock, [&]{ return !queue->busy; });
+  }
+  allocator::forget(this);
 }
 
 void host_stream::synchronize() {
-  for(auto& x: *hst_->futures)
-    x.wait();
-  hst_->futures->clear();
-  hst_->args.clear();
+  if(hst_->capture)
+    throw std::runtime_error("cannot synchronize a stream during capture");
+  host_stream_queue_t* queue = &*hst_->queue;
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  queue->cv.wait(lock, [&]{ return !queue->busy; });
+}
+
+// starts `start`, then the jobs queued after it. jobs that retire before
+// their start returns, such as event records, are followed in this loop
+// rather than from their `done`, so that the stack does not grow with them
+static void start_jobs(host_stream_queue_t* queue, host_stream_queue_t::start_fn_t start) {
+  enum { STARTING, RETIRED, RUNNING };
+  while(true){
+    std::shared_ptr<std::atomic<int>> state(new std::atomic<int>(STARTING));
+    start([queue, state]() {
+      int expected = STARTING;
+      if(state->compare_exchange_strong(expected, RETIRED))
+        return;
+      // retired asynchronously: this thread carries on with the queue
+      host_stream_queue_t::start_fn_t next;
+      {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if(queue->pending.empty()){
+          queue->busy = false;
+          queue->cv.notify_all();
+          return;
+        }
+        next = std::move(queue->pending.front());
+        queue->pending.pop_front();
+      }
+      start_jobs(queue, std::move(next));
+    });
+    int expected = STARTING;
+    if(state->compare_exchange_strong(expected, RUNNING))
+      return;
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if(queue->pending.empty()){
+      queue->busy = false;
+      queue->cv.notify_all();
+      return;
+    }
+    start = std::move(queue->pending.front());
+    queue->pending.pop_front();
+  }
+}
+
+// calls `start` once all previously submitted work retired;
+// `start` must call the function it is given when its work is done
+void host_stream::submit(start_fn_t start) {
+  if(hst_->capture)
+    throw std::runtime_error("only kernel launches can be captured");
+  host_stream_queue_t* queue = &*hst_->queue;
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if(queue->busy){
+      queue->pending.push_back(start);
+      return;
+    }
+    queue->busy = true;
+  }
+  // jobs are started without holding the lock
+  start_jobs(queue, start);
+}
+
+// runs `fn` over [0, n) on the pool once all previously submitted work retired
+void host_stream::submit(size_t n, size_t grain, tools::work_stealing_pool::range_fn_t fn) {
+  if(n == 0)
+    return;
+  tools::work_stealing_pool* pool = &*hst_->pool;
+  submit([pool, n, grain, fn](tools::work_stealing_pool::done_fn_t done) {
+    pool->parallel_for(n, grain, fn, done);
+  });
 }
 
 void host_stream::enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size) {
-  auto hst = kernel->module()->hst();
-  hst_->futures->reserve(hst_->futures->size() + grid[0]*grid[1]*grid[2]);
-  char* params = new char[args_size];
-  std::memcpy((void*)params, (void*)args, args_size);
-  for(size_t i = 0; i < grid[0]; i++)
-    for(size_t j = 0; j < grid[1]; j++)
-      for(size_t k = 0; k < grid[2]; k++)
-        hst_->futures->emplace_back(hst_->pool->enqueue(hst->fn, (char**)params, int32_t(i), int32_t(j), int32_t(k)));
+  auto fn = kernel->module()->hst()->fn;
+  size_t num_programs = grid[0]*grid[1]*grid[2];
+  if(host_graph* graph = hst_->capture){
+    if(num_programs > 0)
+      graph->add({fn, grid, grain(num_programs), std::vector<char>((char*)args, (char*)args + args_size),
+                  kernel->hst()->ptr_offsets, {}, 0});
+    return;
+  }
+  // launches are asynchronous, so arguments must be copied
+  std::shared_ptr<std::vector<char>> params(new std::vector<char>((char*)args, (char*)args + args_size));
+  auto run = [fn, grid, params](size_t begin, size_t end) {
+    run_programs(fn, grid, (char**)params->data(), begin, end);
+  };
+  submit(num_programs, grain(num_programs), run);
+}
+
+void host_stream::wait(driver::event* event) {
+  if(event->backend() != Host)
+    throw std::runtime_error("host streams can only wait for host events");
+  std::shared_ptr<host_event_state_t> state = event->hst()->state;
+  uint64_t id;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    id = state->recorded;
+  }
+  submit([state, id](tools::work_stealing_pool::done_fn_t done) {
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if(!state->has_retired(id)){
+        state->waiters.emplace(id, done);
+        return;
+      }
+    }
+    done();
+  });
+}
+
+void host_stream::begin_capture(host_graph* graph) {
+  if(hst_->capture)
+    throw std::runtime_error("stream is already capturing");
+  hst_->capture = graph;
+}
+
+void host_stream::end_capture() {
+  if(!hst_->capture)
+    throw std::runtime_error("stream is not capturing");
+  hst_->capture->link();
+  hst_->capture = nullptr;
+}
+
+void host_stream::launch(host_graph* graph) {
+  if(graph->nodes_.empty())
+    return;
+  tools::work_stealing_pool* pool = &*hst_->pool;
+  submit([graph, pool](tools::work_stealing_pool::done_fn_t done) {
+    graph->replay(pool, done);
+  });
+}
+
+// a few chunks per worker so that stealing can balance the load
+size_t host_stream::grain(size_t n) {
+  return std::max<size_t>(n / (4*hst_->pool->num_threads()), 1);
+}
+
+// copies are split into chunks of at least 1 MB, handled by the workers;
+// non-blocking copies require `ptr` to stay valid until the stream is synchronized
+void host_stream::copy(char* dst, const char* src, size_t size, bool blocking) {
+  size_t chunk = 1 << 20;
+  size_t num_chunks = (size + chunk - 1) / chunk;
+  submit(num_chunks, grain(num_chunks), [dst, src, size, chunk](size_t begin, size_t end) {
+    size_t lo = begin*chunk;
+    size_t hi = std::min(end*chunk, size);
+    std::memcpy(dst + lo, src + lo, hi - lo);
+  });
+  if(blocking)
+    synchronize();
+}
+
+// fresh memory is not referenced by queued work, so pages
+// are touched right away rather than in stream order
+void host_stream::first_touch(char* ptr, size_t size, size_t page_size) {
+  size_t num_pages = (size + page_size - 1) / page_size;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  hst_->pool->parallel_for(num_pages, grain(num_pages), [ptr, page_size](size_t begin, size_t end) {
+    for(size_t p = begin; p < end; p++)
+      ptr[p*page_size] = 0;
+  }, [&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cv.notify_all();
+  });
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&]{ return done; });
 }
 
 void host_stream::write(driver::buffer* buffer, bool blocking, std::size_t offset, std::size_t size, void const* ptr) {
-  std::memcpy((void*)buffer->hst()->data, ptr, size);
+  if(offset + size > buffer->size())
+    throw std::runtime_error("write out of buffer bounds");
+  copy(buffer->hst()->data + offset, (const char*)ptr, size, blocking);
 }
 
 void host_stream::read(driver::buffer* buffer, bool blocking, std::size_t offset, std::size_t size, void* ptr) {
-  std::memcpy(ptr, (const void*)buffer->hst()->data, size);
+  if(offset + size > buffer->size())
+    throw std::runtime_error("read out of buffer bounds");
+  copy((char*)ptr, buffer->hst()->data + offset, size, blocking);
 }
 
 
@@ -109,10 +424,18 @@ cu_stream::cu_stream(): stream(CUstream(), true) {
   dispatch::cuStreamCreate(&*cu_, 0);
 }
 
+cu_stream::~cu_stream() {
+  allocator::forget(this);
+}
+
 void cu_stream::synchronize() {
   dispatch::cuStreamSynchronize(*cu_);
 }
 
+void cu_stream::wait(driver::event* event) {
+  dispatch::cuStreamWaitEvent(*cu_, *event->cu(), 0);
+}
+
 void cu_stream::enqueue(driver::kernel* kernel, std::array<size_t, 3> grid, std::array<size_t, 3> block, void* args, size_t args_size) {
   void *config[] = {
       CU_LAUNCH_PARAM_BUFFER_POINTER, args,
@@ -2,6 +2,7 @@
 #include "triton/ir/instructions.h"
 #include "triton/ir/type.h"
 #include "triton/ir/function.h"
+#include "triton/ir/module.h"
 
 namespace triton {
 namespace ir {
@@ -16,7 +17,12 @@ basic_block::basic_block(context &ctx, const std::string &name, function *parent
 }
 
 basic_block* basic_block::create(context &ctx, const std::string &name, function *parent){
-  return new basic_block(ctx, name, parent);
+  return new(ctx) basic_block(ctx, name, parent);
+}
+
+void basic_block::bump_version() {
+  if(parent_ && parent_->get_parent())
+    parent_->get_parent()->bump_version();
 }
 
 void basic_block::add_predecessor(basic_block *pred) {
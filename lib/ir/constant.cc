@@ -48,7 +48,7 @@ constant_int *constant_int::get(type *ty, uint64_t value) {
   context_impl *impl = ty->get_context().p_impl.get();
   constant_int *& cst = impl->int_constants_[std::make_pair(ty, value)];
   if(cst == nullptr)
-    cst = new constant_int(ty, value);
+    cst = new(ty->get_context()) constant_int(ty, value);
   return cst;
 }
 
@@ -74,7 +74,7 @@ constant *constant_fp::get(type *ty, double v){
   context_impl *impl = ty->get_context().p_impl.get();
   constant_fp *&result = impl->fp_constants_[std::make_pair(ty, v)];
   if(!result)
-    result = new constant_fp(ty, v);
+    result = new(ty->get_context()) constant_fp(ty, v);
   return result;
 }
 
@@ -87,7 +87,7 @@ undef_value *undef_value::get(type *ty) {
   context_impl *impl = ty->get_context().p_impl.get();
   undef_value *&result = impl->uv_constants_[ty];
   if(!result)
-    result = new undef_value(ty);
+    result = new(ty->get_context()) undef_value(ty);
   return result;
 }
 
@@ -14,7 +14,7 @@ argument::argument(type *ty, const std::string &name, function *parent, unsigned
 
 argument *argument::create(type *ty, const std::string &name,
                           function *parent, unsigned arg_no) {
-  return new argument(ty, name, parent, arg_no);
+  return new(ty->get_context()) argument(ty, name, parent, arg_no);
 }
 
 function* argument::get_parent() const {
@@ -57,7 +57,7 @@ void function::insert_block(basic_block *block, basic_block *next) {
 
 function *function::create(function_type *ty, linkage_types_t linkage,
                            const std::string &name, module *mod) {
-  return new function(ty, linkage, name, mod);
+  return new(ty->get_context()) function(ty, linkage, name, mod);
 }
 
 
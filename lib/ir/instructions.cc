@@ -1,5 +1,6 @@
 #include <algorithm>
 #include "triton/ir/context.h"
+#include "triton/ir/context_impl.h"
 #include "triton/ir/basic_block.h"
 #include "triton/ir/instructions.h"
 #include "triton/ir/constant.h"
@@ -14,15 +15,21 @@ namespace ir{
 
 instruction::instruction(type *ty, value_id_t ity, unsigned num_ops,
                          const std::string &name, instruction *next)
-    : user(ty, num_ops, name), id_(ity) {
+    : user(ty, num_ops, name), parent_(nullptr), id_(ity) {
   if(next){
     basic_block *block = next->get_parent();
     assert(block && "Next instruction is not in a basic block!");
     auto it = std::find(block->begin(), block->end(), next);
     block->get_inst_list().insert(it, next);
+    block->bump_version();
   }
 }
 
+void instruction::operands_changed() {
+  if(parent_)
+    parent_->bump_version();
+}
+
 void instruction::erase_from_parent() {
   parent_->erase(this);
   for(ir::value* op: ops())
@@ -57,6 +64,7 @@ void phi_node::set_incoming_value(unsigned i, value *v){
 void phi_node::set_incoming_block(unsigned i, basic_block *block){
   assert(block && "PHI node got a null basic block!");
   blocks_[i] = block;
+  operands_changed();
 }
 
 // Add incoming
@@ -69,7 +77,7 @@ void phi_node::add_incoming(value *v, basic_block *block){
 
 // Factory methods
 phi_node* phi_node::create(type *ty, unsigned num_reserved, const std::string &name, instruction *next){
-  return new phi_node(ty, num_reserved, name, next);
+  return new(ty->get_context()) phi_node(ty, num_reserved, name, next);
 }
 
 
@@ -135,7 +143,7 @@ binary_operator::binary_operator(binary_op_t op, value *lhs, value *rhs, type *t
 binary_operator *binary_operator::create(binary_op_t op, value *lhs, value *rhs, const std::string &name, instruction *next){
   assert(lhs->get_type() == rhs->get_type() &&
          "Cannot create binary operator with two operands of differing type!");
-  return new binary_operator(op, lhs, rhs, lhs->get_type(), name, next);
+  return new(lhs->get_type()->get_context()) binary_operator(op, lhs, rhs, lhs->get_type(), name, next);
 }
 
 //binary_operator *binary_operator::create_fneg(value *arg, const std::string &name, instruction *next){
@@ -226,7 +234,7 @@ icmp_inst::icmp_inst(type *ty, cmp_pred_t pred,
 icmp_inst* icmp_inst::create(cmp_pred_t pred, value *lhs, value *rhs, const std::string &name, instruction *next){
   assert(is_int_predicate(pred));
   type *res_ty = make_cmp_result_type(lhs->get_type());
-  return new icmp_inst(res_ty, pred, lhs, rhs, name, next);
+  return new(lhs->get_type()->get_context()) icmp_inst(res_ty, pred, lhs, rhs, name, next);
 }
 
 // fcmp_inst
@@ -237,7 +245,7 @@ fcmp_inst::fcmp_inst(type *ty, cmp_pred_t pred,
 fcmp_inst* fcmp_inst::create(cmp_pred_t pred, value *lhs, value *rhs, const std::string &name, instruction *next){
   assert(is_fp_predicate(pred));
   type *res_ty = make_cmp_result_type(lhs->get_type());
-  return new fcmp_inst(res_ty, pred, lhs, rhs, name, next);
+  return new(lhs->get_type()->get_context()) fcmp_inst(res_ty, pred, lhs, rhs, name, next);
 }
 
 //===----------------------------------------------------------------------===//
@@ -281,19 +289,19 @@ cast_inst *cast_inst::create(cast_op_t op, value *arg, type *ty, const std::stri
   assert(is_valid(op, arg, ty) && "Invalid cast!");
   // Construct and return the appropriate CastInst subclass
   switch (op) {
-  case cast_op_t::Trunc:         return new trunc_inst           (ty, arg, name, next);
-  case cast_op_t::ZExt:          return new z_ext_inst           (ty, arg, name, next);
-  case cast_op_t::SExt:          return new s_ext_inst           (ty, arg, name, next);
-  case cast_op_t::FPTrunc:       return new fp_trunc_inst        (ty, arg, name, next);
-  case cast_op_t::FPExt:         return new fp_ext_inst          (ty, arg, name, next);
-  case cast_op_t::UIToFP:        return new ui_to_fp_inst        (ty, arg, name, next);
-  case cast_op_t::SIToFP:        return new si_to_fp_inst        (ty, arg, name, next);
-  case cast_op_t::FPToUI:        return new fp_to_ui_inst        (ty, arg, name, next);
-  case cast_op_t::FPToSI:        return new fp_to_si_inst        (ty, arg, name, next);
-  case cast_op_t::PtrToInt:      return new ptr_to_int_inst      (ty, arg, name, next);
-  case cast_op_t::IntToPtr:      return new int_to_ptr_inst      (ty, arg, name, next);
-  case cast_op_t::BitCast:       return new bit_cast_inst        (ty, arg, name, next);
-  case cast_op_t::AddrSpaceCast: return new addr_space_cast_inst (ty, arg, name, next);
+  case cast_op_t::Trunc:         return new(ty->get_context()) trunc_inst           (ty, arg, name, next);
+  case cast_op_t::ZExt:          return new(ty->get_context()) z_ext_inst           (ty, arg, name, next);
+  case cast_op_t::SExt:          return new(ty->get_context()) s_ext_inst           (ty, arg, name, next);
+  case cast_op_t::FPTrunc:       return new(ty->get_context()) fp_trunc_inst        (ty, arg, name, next);
+  case cast_op_t::FPExt:         return new(ty->get_context()) fp_ext_inst          (ty, arg, name, next);
+  case cast_op_t::UIToFP:        return new(ty->get_context()) ui_to_fp_inst        (ty, arg, name, next);
+  case cast_op_t::SIToFP:        return new(ty->get_context()) si_to_fp_inst        (ty, arg, name, next);
+  case cast_op_t::FPToUI:        return new(ty->get_context()) fp_to_ui_inst        (ty, arg, name, next);
+  case cast_op_t::FPToSI:        return new(ty->get_context()) fp_to_si_inst        (ty, arg, name, next);
+  case cast_op_t::PtrToInt:      return new(ty->get_context()) ptr_to_int_inst      (ty, arg, name, next);
+  case cast_op_t::IntToPtr:      return new(ty->get_context()) int_to_ptr_inst      (ty, arg, name, next);
+  case cast_op_t::BitCast:       return new(ty->get_context()) bit_cast_inst        (ty, arg, name, next);
+  case cast_op_t::AddrSpaceCast: return new(ty->get_context()) addr_space_cast_inst (ty, arg, name, next);
   default: throw std::runtime_error("unreachable");
   }
 }
@@ -322,19 +330,19 @@ return_inst::return_inst(context &ctx, value *ret_val, instruction *next)
 }
 
 return_inst *return_inst::create(context &ctx, value *ret_val, instruction *next){
-  return new return_inst(ctx, ret_val, next);
+  return new(ctx) return_inst(ctx, ret_val, next);
 }
 
 
 // branch_inst
 branch_inst* branch_inst::create(basic_block *dst, instruction *next) {
   assert(dst && "Branch destination may not be null!");
-  return new uncond_branch_inst(dst, next);
+  return new(dst->get_type()->get_context()) uncond_branch_inst(dst, next);
 }
 
 branch_inst* branch_inst::create(value *cond, basic_block *if_dst, basic_block *else_dst, instruction *next) {
   assert(cond->get_type()->is_integer_ty(1) && "May only branch on boolean predicates!");
-  return new cond_branch_inst(if_dst, else_dst, cond, next);
+  return new(if_dst->get_type()->get_context()) cond_branch_inst(if_dst, else_dst, cond, next);
 }
 
 // uncond_branch_inst
@@ -412,7 +420,7 @@ type *getelementptr_inst::get_indexed_type(type *ty, const std::vector<value *>
 
 getelementptr_inst *getelementptr_inst::create(value *ptr, const std::vector<value *> &idx, const std::string &name, instruction *next) {
   type *pointee_ty = ((pointer_type*)(ptr->get_type()->get_scalar_ty()))->get_element_ty();
-  return new getelementptr_inst(pointee_ty, ptr, idx, name, next);
+  return new(ptr->get_type()->get_context()) getelementptr_inst(pointee_ty, ptr, idx, name, next);
 }
 
 
@@ -446,7 +454,7 @@ unmasked_load_inst::unmasked_load_inst(value *ptr, const std::string &name, inst
 }
 
 unmasked_load_inst* unmasked_load_inst::create(value *ptr, const std::string &name, instruction *next) {
-  return new unmasked_load_inst(ptr, name, next);
+  return new(ptr->get_type()->get_context()) unmasked_load_inst(ptr, name, next);
 }
 
 // masked load
@@ -460,7 +468,7 @@ masked_load_inst::masked_load_inst(value *ptr, value *mask, value *false_value,
 
 masked_load_inst* masked_load_inst::create(value *ptr, value *mask, value *false_value,
                                            const std::string &name, instruction *next) {
-  return new masked_load_inst(ptr, mask, false_value, name, next);
+  return new(ptr->get_type()->get_context()) masked_load_inst(ptr, mask, false_value, name, next);
 }
 
 // masked load async
@@ -474,7 +482,7 @@ masked_load_async_inst::masked_load_async_inst(value *ptr, value *mask, value *f
 
 masked_load_async_inst* masked_load_async_inst::create(value *ptr, value *mask, value *false_value,
                                            const std::string &name, instruction *next) {
-  return new masked_load_async_inst(ptr, mask, false_value, name, next);
+  return new(ptr->get_type()->get_context()) masked_load_async_inst(ptr, mask, false_value, name, next);
 }
 
 // atomic add
@@ -487,7 +495,7 @@ atomic_add_inst::atomic_add_inst(value *ptr, value *val, value *msk, const std::
 }
 
 instruction* atomic_add_inst::create(value *ptr, value *val, value *msk, const std::string &name, instruction *next) {
-  return new atomic_add_inst(ptr, val, msk, name, next);
+  return new(ptr->get_type()->get_context()) atomic_add_inst(ptr, val, msk, name, next);
 }
 
 // store
@@ -506,7 +514,7 @@ unmasked_store_inst::unmasked_store_inst(value *ptr, value *val,
 
 unmasked_store_inst* unmasked_store_inst::create(value *ptr, value *val,
                                                  const std::string &name, instruction *next) {
-  return new unmasked_store_inst(ptr, val, name, next);
+  return new(ptr->get_type()->get_context()) unmasked_store_inst(ptr, val, name, next);
 }
 
 // masked store
@@ -519,7 +527,7 @@ masked_store_inst::masked_store_inst(value *ptr, value *val, value *mask,
 }
 
 masked_store_inst* masked_store_inst::create(value *ptr, value *val, value *mask, const std::string &name, instruction *next)  {
-  return new masked_store_inst(ptr, val, mask, name, next);
+  return new(ptr->get_type()->get_context()) masked_store_inst(ptr, val, mask, name, next);
 }
 //===----------------------------------------------------------------------===//
 //                               retile_inst classes
@@ -534,7 +542,7 @@ retile_inst::retile_inst(value *arg, value_id_t id, const type::tile_shapes_t &s
 
 instruction* reshape_inst::create(value *arg, const type::tile_shapes_t &shapes,
                                   const std::string &name, instruction *next) {
-  return new reshape_inst(arg, INST_RESHAPE, shapes, name, next);
+  return new(arg->get_type()->get_context()) reshape_inst(arg, INST_RESHAPE, shapes, name, next);
 }
 
 
@@ -542,20 +550,20 @@ instruction* reshape_inst::create(value *arg, const type::tile_shapes_t &shapes,
 
 instruction* splat_inst::create(value *arg, const type::tile_shapes_t &shapes,
                                   const std::string &name, instruction *next) {
-  return new splat_inst(arg, INST_SPLAT, shapes, name, next);
+  return new(arg->get_type()->get_context()) splat_inst(arg, INST_SPLAT, shapes, name, next);
 }
 
 // broadcast
 
 instruction* broadcast_inst::create(value *arg, const type::tile_shapes_t &shapes,
                                   const std::string &name, instruction *next) {
-  return new broadcast_inst(arg, INST_BROADCAST, shapes, name, next);
+  return new(arg->get_type()->get_context()) broadcast_inst(arg, INST_BROADCAST, shapes, name, next);
 }
 
 // downcast
 
 instruction* downcast_inst::create(value *arg, const std::string &name, instruction *next) {
-  return new downcast_inst(arg->get_type()->get_scalar_ty(), INST_DOWNCAST, arg, name, next);
+  return new(arg->get_type()->get_context()) downcast_inst(arg->get_type()->get_scalar_ty(), INST_DOWNCAST, arg, name, next);
 }
 
 //===----------------------------------------------------------------------===//
@@ -575,27 +583,27 @@ instruction *dot_inst::create(value *A, value *B, value *C,
                               const std::string &name, instruction *next) {
   TransT OPA = AT ? Trans : NoTrans;
   TransT OPB = BT ? Trans : NoTrans;
-  return new dot_inst(A, B, C, OPA, OPB, name, next);
+  return new(A->get_type()->get_context()) dot_inst(A, B, C, OPA, OPB, name, next);
 }
 
 instruction *dot_inst::create_nn(value *A, value *B, value *C,
                                  const std::string &name, instruction *next) {
-  return new dot_inst(A, B, C, NoTrans, NoTrans, name, next);
+  return new(A->get_type()->get_context()) dot_inst(A, B, C, NoTrans, NoTrans, name, next);
 }
 
 instruction *dot_inst::create_nt(value *A, value *B, value *C,
                                  const std::string &name, instruction *next) {
-  return new dot_inst(A, B, C, NoTrans, Trans, name, next);
+  return new(A->get_type()->get_context()) dot_inst(A, B, C, NoTrans, Trans, name, next);
 }
 
 instruction *dot_inst::create_tn(value *A, value *B, value *C,
                                  const std::string &name, instruction *next) {
-  return new dot_inst(A, B, C, Trans, NoTrans, name, next);
+  return new(A->get_type()->get_context()) dot_inst(A, B, C, Trans, NoTrans, name, next);
 }
 
 instruction *dot_inst::create_tt(value *A, value *B, value *C,
                                  const std::string &name, instruction *next) {
-  return new dot_inst(A, B, C, Trans, Trans, name, next);
+  return new(A->get_type()->get_context()) dot_inst(A, B, C, Trans, Trans, name, next);
 }
 
 //===----------------------------------------------------------------------===//
@@ -635,7 +643,7 @@ trans_inst::trans_inst(value *arg, const std::vector<int> &perm, const std::stri
 }
 
 instruction* trans_inst::create(value *arg, const std::vector<int> &perm, const std::string &name, instruction *next) {
-  return new trans_inst(arg, perm, name, next);
+  return new(arg->get_type()->get_context()) trans_inst(arg, perm, name, next);
 }
 
 const std::vector<int> trans_inst::get_perm() const {
@@ -652,7 +660,7 @@ sqrt_inst::sqrt_inst(value *arg, const std::string &name, instruction *next)
 }
 
 instruction* sqrt_inst::create(value *arg, const std::string &name, instruction *next) {
-  return new sqrt_inst(arg, name, next);
+  return new(arg->get_type()->get_context()) sqrt_inst(arg, name, next);
 }
 
 //===----------------------------------------------------------------------===//
@@ -693,7 +701,7 @@ reduce_inst::reduce_inst(value *arg, op_t op, unsigned axis, const std::string &
 }
 
 instruction* reduce_inst::create(value *arg, op_t op, unsigned axis, const std::string &name, instruction *next) {
-  return new reduce_inst(arg, op, axis, name, next);
+  return new(arg->get_type()->get_context()) reduce_inst(arg, op, axis, name, next);
 }
 
 
@@ -709,7 +717,7 @@ select_inst::select_inst(value *pred, value *if_value, value *else_value, const
 }
 
 instruction* select_inst::create(value *pred, value *if_value, value *else_value, const std::string &name, instruction *next) {
-  return new select_inst(pred, if_value, else_value, name, next);
+  return new(pred->get_type()->get_context()) select_inst(pred, if_value, else_value, name, next);
 }
 //===----------------------------------------------------------------------===//
 //                               builtin instructions
@@ -723,7 +731,7 @@ get_program_id_inst::get_program_id_inst(type *ty, unsigned axis, const std::str
 }
 
 instruction* get_program_id_inst::create(context &ctx, unsigned axis, const std::string &name, instruction *next) {
-  return new get_program_id_inst(type::get_int32_ty(ctx), axis, name, next);
+  return new(ctx) get_program_id_inst(type::get_int32_ty(ctx), axis, name, next);
 }
 
 // get_num_program
@@ -733,7 +741,7 @@ get_num_program_inst::get_num_program_inst(type *ty, unsigned axis, const std::s
 }
 
 instruction* get_num_program_inst::create(context &ctx, unsigned axis, const std::string &name, instruction *next) {
-  return new get_num_program_inst(type::get_int32_ty(ctx), axis, name, next);
+  return new(ctx) get_num_program_inst(type::get_int32_ty(ctx), axis, name, next);
 }
 
 
@@ -747,7 +755,7 @@ atomic_cas_inst::atomic_cas_inst(value *ptr, value *cmp, value *val, const std::
 }
 
 instruction* atomic_cas_inst::create(value *ptr, value *cmp, value *val, const std::string &name, instruction *next) {
-  return new atomic_cas_inst(ptr, cmp, val, name, next);
+  return new(ptr->get_type()->get_context()) atomic_cas_inst(ptr, cmp, val, name, next);
 }
 
 // atomic exch
@@ -759,7 +767,7 @@ atomic_exch_inst::atomic_exch_inst(value *ptr, value *val, const std::string &na
 }
 
 instruction* atomic_exch_inst::create(value *ptr, value *val, const std::string &name, instruction *next) {
-  return new atomic_exch_inst(ptr, val, name, next);
+  return new(ptr->get_type()->get_context()) atomic_exch_inst(ptr, val, name, next);
 }
 
 
@@ -771,7 +779,7 @@ exp_inst::exp_inst(value *val, const std::string &name, instruction *next)
 }
 
 instruction* exp_inst::create(value *val, const std::string& name, instruction *next) {
-  return new exp_inst(val, name, next);
+  return new(val->get_type()->get_context()) exp_inst(val, name, next);
 }
 
 // log
@@ -782,7 +790,7 @@ log_inst::log_inst(value *val, const std::string &name, instruction *next)
 }
 
 instruction* log_inst::create(value *val, const std::string& name, instruction *next) {
-  return new log_inst(val, name, next);
+  return new(val->get_type()->get_context()) log_inst(val, name, next);
 }
 
 
@@ -793,18 +801,18 @@ instruction* log_inst::create(value *val, const std::string& name, instruction *
 // copy to shared
 copy_to_shared_inst* copy_to_shared_inst::create(value *arg, const std::string &name,
                                                  instruction *next) {
-  return new copy_to_shared_inst(arg->get_type(), INST_COPY_TO_SHARED, arg, name, next);
+  return new(arg->get_type()->get_context()) copy_to_shared_inst(arg->get_type(), INST_COPY_TO_SHARED, arg, name, next);
 }
 
 // copy from shared
 copy_from_shared_inst* copy_from_shared_inst::create(value *arg, const std::string &name,
                                                  instruction *next) {
-  return new copy_from_shared_inst(arg->get_type(), INST_COPY_FROM_SHARED, arg, name, next);
+  return new(arg->get_type()->get_context()) copy_from_shared_inst(arg->get_type(), INST_COPY_FROM_SHARED, arg, name, next);
 }
 
 // recoalesce
 recoalesce_inst* recoalesce_inst::create(value *arg, const std::string &name, instruction *next) {
-  return new recoalesce_inst(arg->get_type(), INST_RECOALESCE, arg, name, next);
+  return new(arg->get_type()->get_context()) recoalesce_inst(arg->get_type(), INST_RECOALESCE, arg, name, next);
 }
 
 
@@ -815,7 +823,7 @@ barrier_inst::barrier_inst(context &ctx, const std::string &name,
   : instruction(type::get_void_ty(ctx), INST_BARRIER, 0, name, next) { }
 
 barrier_inst* barrier_inst::create(context &ctx, const std::string &name, instruction *next) {
-  return new barrier_inst(ctx, name, next);
+  return new(ctx) barrier_inst(ctx, name, next);
 }
 
 async_wait_inst::async_wait_inst(context &ctx, const std::string &name,
@@ -823,7 +831,7 @@ async_wait_inst::async_wait_inst(context &ctx, const std::string &name,
   : instruction(type::get_void_ty(ctx), INST_ASYNC_WAIT, 0, name, next) { }
 
 async_wait_inst* async_wait_inst::create(context &ctx, const std::string &name, instruction *next) {
-  return new async_wait_inst(ctx, name, next);
+  return new(ctx) async_wait_inst(ctx, name, next);
 }
 
 
@@ -832,7 +840,7 @@ make_range_dyn::make_range_dyn(type *ty, const std::string &name, instruction *n
   : instruction(ty, INST_MAKE_RANGE_DYN, 0, name, next) { }
 
 make_range_dyn* make_range_dyn::create(type *ty, const std::string &name, instruction *next) {
-  return new make_range_dyn(ty, name, next);
+  return new(ty->get_context()) make_range_dyn(ty, name, next);
 }
 
 // nv_static_program_idx
@@ -843,10 +851,11 @@ make_range* make_range_sta::get_range() const
 { return range_; }
 
 make_range_sta* make_range_sta::get(make_range* range) {
-  static std::map<make_range*, make_range_sta*> cache;
-  if(cache.find(range) == cache.end())
-    cache.insert({range, new make_range_sta(range)});
-  return cache.at(range);
+  context_impl *impl = range->get_type()->get_context().p_impl.get();
+  make_range_sta *&result = impl->mr_sta_constants_[range];
+  if(!result)
+    result = new(range->get_type()->get_context()) make_range_sta(range);
+  return result;
 }
 
 
@@ -859,7 +868,7 @@ make_range *make_range::create(constant_int *first, constant_int *last) {
   assert(first->get_type() == last->get_type());
   assert(((constant_int*)first)->get_value() == 0);
   type *ty = tile_type::get(first->get_type(), {(unsigned)last->get_value()});
-  return new make_range(ty, first, last);
+  return new(first->get_type()->get_context()) make_range(ty, first, last);
 }
 
 const constant_int* make_range::get_first() const {
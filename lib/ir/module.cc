@@ -73,7 +73,7 @@ ir::value *module::try_remove_trivial_phis(ir::phi_node *&phi){
   assert(same != nullptr);
   phi->replace_all_uses_with(same);
   phi->erase_from_parent();
-  std::set<ir::user*> users = phi->get_users();
+  ir::value::users_t users = phi->get_users();
   for(ir::user* u: users)
   if(auto *uphi = dynamic_cast<ir::phi_node*>(u))
     if(uphi != phi)
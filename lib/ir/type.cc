@@ -12,6 +12,17 @@ namespace ir{
 //                              type class
 //===----------------------------------------------------------------------===//
 
+void* type::operator new(size_t size, context& ctx) {
+  tools::arena& arena = ctx.p_impl->arena;
+  void* ptr = arena.allocate(size);
+  arena.add_finalizer([](void* x) { ((type*)x)->~type(); }, ptr);
+  return ptr;
+}
+
+void type::operator delete(void* ptr, context& ctx) {
+  ctx.p_impl->arena.remove_finalizer(ptr);
+}
+
 // attributes
 type *type::get_scalar_ty() const {
   if(is_tile_ty())
@@ -151,7 +162,7 @@ pointer_type* pointer_type::get(type *elt_ty, unsigned address_space){
   context_impl *impl = elt_ty->get_context().p_impl.get();
   pointer_type *&entry = impl->ptr_tys[std::make_pair(elt_ty, address_space)];
   if(!entry)
-    entry = new pointer_type(elt_ty, address_space);
+    entry = new(elt_ty->get_context()) pointer_type(elt_ty, address_space);
   return entry;
 }
 
@@ -201,7 +212,7 @@ tile_type* tile_type::get(type *elt_ty, const tile_shapes_t &shapes) {
   context_impl *impl = elt_ty->get_context().p_impl.get();
   tile_type *&entry = impl->tile_tys[std::make_pair(elt_ty, shapes)];
   if(!entry)
-    entry = new tile_type(elt_ty, shapes);
+    entry = new(elt_ty->get_context()) tile_type(elt_ty, shapes);
   return entry;
 }
 
@@ -222,7 +233,7 @@ function_type::function_type(type *ret_ty, const std::vector<type*> &param_tys):
 }
 
 function_type* function_type::get(type *ret_ty, const std::vector<type *> &param_tys) {
-  return new function_type(ret_ty, param_tys);
+  return new(ret_ty->get_context()) function_type(ret_ty, param_tys);
 }
 
 }
@@ -1,7 +1,10 @@
 #include <cassert>
+#include <algorithm>
 #include <iostream>
 #include "triton/ir/value.h"
 #include "triton/ir/instructions.h"
+#include "triton/ir/context.h"
+#include "triton/ir/context_impl.h"
 
 namespace triton{
 namespace ir{
@@ -12,19 +15,59 @@ class type;
 //                               value class
 //===----------------------------------------------------------------------===//
 
+void* value::operator new(size_t size, context& ctx) {
+  tools::arena& arena = ctx.p_impl->arena;
+  void* ptr = arena.allocate(size);
+  arena.add_finalizer([](void* x) { ((value*)x)->~value(); }, ptr);
+  return ptr;
+}
+
+void value::operator delete(void* ptr, context& ctx) {
+  ctx.p_impl->arena.remove_finalizer(ptr);
+}
+
 value::value(type *ty, const std::string &name): ty_(ty){
   set_name(name);
 }
 
+// users are looked up by a linear scan while there are few of them
+static const size_t max_scanned_users = 8;
+
 void value::add_use(user *arg) {
-  users_.insert(arg);
+  if(user_pos_.empty() && users_.size() < max_scanned_users){
+    if(std::find(users_.begin(), users_.end(), arg) == users_.end())
+      users_.push_back(arg);
+    return;
+  }
+  if(user_pos_.empty())
+    for(size_t i = 0; i < users_.size(); i++)
+      user_pos_[users_[i]] = i;
+  if(user_pos_.emplace(arg, users_.size()).second)
+    users_.push_back(arg);
 }
 
+// the last user takes the place of the erased one, so that
+// iterating while erasing visits every remaining user once
 value::users_t::iterator value::erase_use(user *arg){
-  auto it = users_.find(arg);
-  if(it == users_.end())
-    return it;
-  return users_.erase(it);
+  size_t idx;
+  if(user_pos_.empty()){
+    auto it = std::find(users_.begin(), users_.end(), arg);
+    if(it == users_.end())
+      return it;
+    idx = it - users_.begin();
+  }
+  else{
+    auto it = user_pos_.find(arg);
+    if(it == user_pos_.end())
+      return users_.end();
+    idx = it->second;
+    user_pos_.erase(it);
+    if(idx + 1 < users_.size())
+      user_pos_[users_.back()] = idx;
+  }
+  users_[idx] = users_.back();
+  users_.pop_back();
+  return users_.begin() + idx;
 }
 
 // TODO: automatic naming scheme + update symbol table
@@ -51,6 +94,7 @@ void user::set_operand(unsigned i, value *x) {
   assert(i < ops_.size() && "set_operand() out of range!");
   ops_[i] = x;
   x->add_use(this);
+  operands_changed();
 }
 
 value* user::get_operand(unsigned i) const {
@@ -67,11 +111,15 @@ unsigned user::get_num_hidden() const {
 }
 
 value::users_t::iterator user::replace_uses_of_with(value *before, value *after) {
+  bool changed = false;
   for(size_t i = 0; i < ops_.size(); i++)
     if(ops_[i] == before){
       ops_[i] = after;
       after->add_use(this);
+      changed = true;
     }
+  if(changed && before != after)
+    operands_changed();
   return before->erase_use(this);
 }
 
@@ -334,7 +334,7 @@ void Generator::VisitFuncCall(FuncCall* funcCall) {
     ir::value* ret = ret_;
     ir::constant_int *size = dynamic_cast<ir::constant_int*>(ret);
     assert(size);
-    ir::alloc_const* alloc = new ir::alloc_const(bld_->get_int8_ty(), size);
+    ir::alloc_const* alloc = new(size->get_type()->get_context()) ir::alloc_const(bld_->get_int8_ty(), size);
     mod_->add_alloc(alloc);
     return set_ret(alloc);
   }
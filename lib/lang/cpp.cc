@@ -167,6 +167,8 @@ void Preprocessor::Glue(TokenSequence& os, const Token* tok) {
 void Preprocessor::Glue(TokenSequence& os, TokenSequence is) {
   auto lhs = os.Back();
   auto rhs = is.Peek();
+  CheckSymbol(lhs);
+  CheckSymbol(rhs);
 
   auto str = new std::string(lhs->str_ + rhs->str_);
   TokenSequence ts;
@@ -202,6 +204,7 @@ const Token* Preprocessor::Stringize(TokenSequence is) {
   std::string str = "\"";
   while (!is.Empty()) {
     auto tok = is.Next();
+    CheckSymbol(tok);
     // Have preceding white space
     // and is not the first token of the sequence
     str.append(tok->ws_ && str.size() > 1, ' ');
@@ -258,6 +261,39 @@ void Preprocessor::Process(TokenSequence& os) {
 }
 
 
+void Preprocessor::Specialize(TokenSequence& os, TokenSequence is,
+                              const std::map<std::string, const std::string*>& values) {
+  while (!is.Empty()) {
+    auto tok = is.Next();
+    auto it = tok->tag_ == Token::IDENTIFIER ? values.find(tok->str_) : values.end();
+    if (it == values.end()) {
+      os.InsertBack(tok);
+      continue;
+    }
+    TokenSequence ts;
+    Scanner scanner(it->second, tok->loc_);
+    scanner.Tokenize(ts);
+    bool first = true;
+    while (!ts.Empty()) {
+      auto val = const_cast<Token*>(ts.Next());
+      if (val->tag_ == Token::INVALID)
+        throw SymbolicMacroError(tok->str_);
+      if (val->tag_ == Token::IDENTIFIER) {
+        auto tag = Token::KeyWordTag(val->str_);
+        if (!Token::IsKeyWord(tag))
+          throw SymbolicMacroError(tok->str_);
+        val->tag_ = tag;
+      }
+      val->loc_ = tok->loc_;
+      if (first)
+        val->ws_ = tok->ws_;
+      first = false;
+      os.InsertBack(val);
+    }
+  }
+}
+
+
 const Token* Preprocessor::ParseActualParam(TokenSequence& is,
                                             Macro* macro,
                                             ParamMap& paramMap) {
@@ -310,6 +346,7 @@ const Token* Preprocessor::ParseActualParam(TokenSequence& is,
 const Token* Preprocessor::EvalDefOp(TokenSequence& is) {
   auto hasPar = is.Try('(');
   auto macro = is.Expect(Token::IDENTIFIER);
+  CheckSymbol(macro);
   auto cons = Token::New(*macro);
   if (hasPar) is.Expect(')');
   cons->tag_ = Token::I_CONSTANT;
@@ -322,6 +359,7 @@ void Preprocessor::ReplaceIdent(TokenSequence& is) {
   TokenSequence os;
   while (!is.Empty()) {
     auto tok = is.Next();
+    CheckSymbol(tok);
     if (tok->tag_ == Token::IDENTIFIER) {
       auto cons = Token::New(*tok);
       cons->tag_ = Token::I_CONSTANT;
@@ -490,6 +528,7 @@ void Preprocessor::ParseIfdef(TokenSequence ls) {
 
   ls.Next();
   auto ident = ls.Expect(Token::IDENTIFIER);
+  CheckSymbol(ident);
   if (!ls.Empty()) {
     Error(ls.Peek(), "expect new line");
   }
@@ -667,6 +706,7 @@ void Preprocessor::ParseUndef(TokenSequence ls) {
   ls.Next(); // Skip directive
 
   auto ident = ls.Expect(Token::IDENTIFIER);
+  CheckSymbol(ident);
   if (!ls.Empty())
     Error(ls.Peek(), "expect new line");
 
@@ -677,6 +717,7 @@ void Preprocessor::ParseUndef(TokenSequence ls) {
 void Preprocessor::ParseDef(TokenSequence ls) {
   ls.Next();
   auto ident = ls.Expect(Token::IDENTIFIER);
+  CheckSymbol(ident);
   if (ident->str_ == "defined") {
     Error(ident, "'defined' cannot be used as a macro name");
   }
@@ -0,0 +1,70 @@
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include "triton/runtime/bundle.h"
+
+namespace triton{
+namespace runtime{
+
+std::string bundle_t::to_str() const {
+  std::ostringstream oss;
+  oss << name << '\n';
+  for(size_t i = 0; i < sig.size(); i++)
+    oss << (i ? "\t" : "") << (int)sig[i];
+  oss << '\n';
+  for(size_t i = 0; i < arg_names.size(); i++)
+    oss << (i ? "\t" : "") << arg_names[i];
+  oss << '\n';
+  for(const config_t& x: configs){
+    oss << x.entry << '\t' << x.opt.num_warps;
+    std::map<std::string, std::string> defines(x.opt.defines.begin(), x.opt.defines.end());
+    for(const auto& d: defines)
+      oss << '\t' << d.first << '=' << d.second;
+    oss << '\n';
+  }
+  return oss.str();
+}
+
+bundle_t bundle_t::parse(const std::string& str) {
+  auto split = [](const std::string& line) {
+    std::vector<std::string> ret;
+    std::istringstream iss(line);
+    std::string field;
+    while(std::getline(iss, field, '\t'))
+      ret.push_back(field);
+    return ret;
+  };
+  bundle_t ret;
+  std::istringstream iss(str);
+  std::string line;
+  if(!std::getline(iss, ret.name) || ret.name.empty())
+    throw std::runtime_error("invalid bundle: missing name");
+  if(!std::getline(iss, line))
+    throw std::runtime_error("invalid bundle " + ret.name + ": missing signature");
+  for(const std::string& ty: split(line))
+    ret.sig.push_back((arg_type)std::stoi(ty));
+  if(!std::getline(iss, line))
+    throw std::runtime_error("invalid bundle " + ret.name + ": missing argument names");
+  ret.arg_names = split(line);
+  while(std::getline(iss, line)){
+    std::vector<std::string> fields = split(line);
+    if(fields.size() < 2)
+      throw std::runtime_error("invalid bundle " + ret.name + ": malformed configuration");
+    config_t config;
+    config.entry = fields[0];
+    config.opt.num_warps = std::stoul(fields[1]);
+    for(size_t i = 2; i < fields.size(); i++){
+      size_t eq = fields[i].find('=');
+      if(eq == std::string::npos)
+        throw std::runtime_error("invalid bundle " + ret.name + ": malformed define " + fields[i]);
+      config.opt.defines[fields[i].substr(0, eq)] = fields[i].substr(eq + 1);
+    }
+    ret.configs.push_back(config);
+  }
+  if(ret.configs.empty())
+    throw std::runtime_error("invalid bundle " + ret.name + ": no configuration");
+  return ret;
+}
+
+}
+}
@@ -5,21 +5,10 @@
 #include <algorithm>
 #include <sstream>
 #include <memory>
-#include "triton/codegen/analysis/axes.h"
-#include "triton/codegen/analysis/allocation.h"
-#include "triton/codegen/analysis/liveness.h"
-#include "triton/codegen/analysis/align.h"
-#include "triton/codegen/analysis/swizzle.h"
-#include "triton/codegen/transform/coalesce.h"
-#include "triton/codegen/transform/dce.h"
-#include "triton/codegen/transform/peephole.h"
-#include "triton/codegen/transform/membar.h"
-#include "triton/codegen/transform/reassociate.h"
-#include "triton/codegen/transform/reorder.h"
-#include "triton/codegen/transform/cts.h"
-#include "triton/codegen/transform/disassociate.h"
-#include "triton/codegen/selection/generator.h"
+#include "triton/codegen/pipeline.h"
+#include "triton/codegen/target.h"
 #include "triton/runtime/function.h"
+#include "triton/runtime/bundle.h"
 #include "triton/lang/cpp.h"
 #include "triton/lang/parser.h"
 #include "triton/lang/code_gen.h"
@@ -36,8 +25,18 @@
 #include "triton/tools/sha1.hpp"
 #include "triton/tools/sys/getenv.hpp"
 #include "triton/tools/sys/mkdir.hpp"
+#include "triton/tools/thread_pool.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
+#include <dlfcn.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
 #include <mutex>
+#include <thread>
+#include <future>
 #include <fstream>
 
 std::mutex mut;
@@ -49,6 +48,15 @@ namespace runtime {
 /* --------------------------------- */
 /* --------------------------------- */
 
+std::string options_t::to_str() const {
+  std::map<std::string, std::string> sorted(defines.begin(), defines.end());
+  std::ostringstream oss;
+  oss << "num_warps=" << num_warps;
+  for(const auto& x: sorted)
+    oss << "," << x.first << "=" << x.second;
+  return oss.str();
+}
+
 arg_type kernel::convert(ir::type *ty) {
   if(ty->is_integer_ty(1))  return INT1_T;
   if(ty->is_integer_ty(8))  return INT8_T;
@@ -117,21 +125,29 @@ typedef long int64;
 )";
 }
 
-void kernel::init_ir(const std::string& src) {
-  // pre-process
-  TokenSequence tokens;
-  Preprocessor cpp(&src, true);
-  for(auto it: opt.defines)
-    cpp.AddMacro(it.first, &it.second);
-  cpp.Process(tokens);
-  // src -> ast
-  Parser parser(tokens);
-  parser.Parse();
-  // ast -> triton-ir
-  ir::module* module = new ir::module("", ctx_);
-  Generator gen(&parser);
-  gen.Gen(module);
-  ir_.reset(module);
+void kernel::init_ir(const std::string& src, frontend* fe) {
+  // the front-end allocates from process-wide pools
+  // and is therefore not thread-safe
+  std::lock_guard<std::mutex> lock(mut);
+  pm_.run("frontend", [&]() {
+    // pre-process
+    TokenSequence tokens;
+    if(!fe || !fe->specialize(tokens, opt)){
+      tokens = TokenSequence();
+      Preprocessor cpp(&src, true);
+      for(auto it: opt.defines)
+        cpp.AddMacro(it.first, &it.second);
+      cpp.Process(tokens);
+    }
+    // src -> ast
+    Parser parser(tokens);
+    parser.Parse();
+    // ast -> triton-ir
+    ir::module* module = new ir::module("", ctx_);
+    Generator gen(&parser);
+    gen.Gen(module);
+    ir_.reset(module);
+  });
 }
 
 void kernel::init_ker(){
@@ -140,60 +156,19 @@ void kernel::init_ker(){
   std::unique_ptr<codegen::target> target = dev_->make_target();
   // generate llvm code
   llvm::LLVMContext ctx;
-  std::string name = ir_->get_function_list()[0]->get_name();
-  std::unique_ptr<llvm::Module> llvm(new llvm::Module(name, ctx));
+  name_ = ir_->get_function_list()[0]->get_name();
+  std::unique_ptr<llvm::Module> llvm(new llvm::Module(name_, ctx));
   // optimizations
-  bool cts_use_async = target->as_nvidia()->sm() >= 80;
-  // create passes
-  codegen::analysis::align align;
-  codegen::analysis::axes axes;
-  codegen::transform::cts cts(cts_use_async);
-  codegen::transform::disassociate disassociate;
-  codegen::analysis::layouts layouts(&axes, &align, opt.num_warps, target.get());
-  codegen::analysis::liveness liveness(&layouts);
-  codegen::analysis::swizzle swizzle(&layouts, target.get());
-  codegen::analysis::allocation allocation(&liveness);
-  codegen::transform::membar barriers(&liveness, &layouts, &allocation);
-  codegen::transform::dce dce;
-  codegen::transform::peephole peephole(target.get());
-  codegen::transform::reassociate reassociate;
-  codegen::transform::coalesce coalesce(&align, &layouts);
-  codegen::generator isel(&axes, &layouts, &align, &allocation, &swizzle, target.get(), opt.num_warps);
-  // run passes
-  dce.run(*ir_);
-  disassociate.run(*ir_);
-  dce.run(*ir_);
-  peephole.run(*ir_);
-  dce.run(*ir_);
-  align.run(*ir_);
-  if(target->is_gpu())
-    cts.run(*ir_);
-  axes.run(*ir_);
-  layouts.run(*ir_);
-  coalesce.run(*ir_);
-  dce.run(*ir_);
-  align.run(*ir_);
-  dce.run(*ir_);
-  if(target->is_gpu()){
-    reassociate.run(*ir_);
-    cts.run(*ir_);
-  }
-  peephole.run(*ir_);
-  dce.run(*ir_);
-  align.run(*ir_);
-  axes.run(*ir_);
-  layouts.run(*ir_);
-  swizzle.run(*ir_);
-  liveness.run(*ir_);
-  allocation.run(*ir_);
-  if(allocation.allocated_size() > dev_->max_shared_memory())
+  codegen::pipeline pipeline(target.get(), opt.num_warps);
+  pm_.run(pipeline.schedule(), *ir_);
+  if(pipeline.allocated_size() > dev_->max_shared_memory())
     throw exception::out_of_shared_memory();
-  barriers.run(*ir_);
-  isel.visit(*ir_, *llvm);
+  pm_.run("membar", *ir_, [&]() { pipeline.insert_barriers(*ir_); });
+  pm_.run("generator", *ir_, [&]() { pipeline.generate(*ir_, *llvm); });
   //if(res->spilled() > 256)
   //  throw exception::out_of_registers();
-  mod_.reset(driver::module::create(dev_, std::move(llvm)));
-  ker_.reset(driver::kernel::create(&*mod_, name.c_str()));
+  pm_.run("llvm-codegen", [&]() { mod_.reset(driver::module::create(dev_, std::move(llvm))); });
+  ker_.reset(driver::kernel::create(&*mod_, name_.c_str()));
 }
 
 void kernel::init_sig() {
@@ -201,16 +176,165 @@ void kernel::init_sig() {
   ir::function_type* ty = fn->get_fn_type();
   for(size_t i = 0; i < ty->get_num_params(); i++){
     sig_.push_back(convert(ty->get_param_ty(i)));
+    arg_names_.push_back(fn->args()[i]->get_name());
     if(!fn->has_attr(i+1))
       continue;
   }
 }
 
-kernel::kernel(const std::string& src, const options_t& opt, driver::device *dev):
+// lets host graphs find the dependencies between launches
+void kernel::init_ptr_offsets() {
+  if(ker_->backend() != driver::Host)
+    return;
+  std::vector<size_t>& ptr_offsets = ker_->hst()->ptr_offsets;
+  size_t offset = 0;
+  for(arg_type ty: sig_){
+    size_t size = size_of(ty);
+    offset = (offset + size - 1) / size * size;
+    if(ty == BUFFER_T)
+      ptr_offsets.push_back(offset);
+    offset += size;
+  }
+}
+
+std::string kernel::cache_path(const std::string& src) const {
+#ifndef TRITON_BUILD_ID
+  // without a hash of the compiler sources, cached binaries may be stale
+  return "";
+#endif
+  // cache location
+  std::string dir = tools::getenv("TRITON_CACHE_DIR");
+  if(dir.empty()){
+    std::string home = tools::getenv("HOME");
+    if(home.empty())
+      return "";
+    dir = home + "/.triton/cache/";
+  }
+  if(dir.back() != '/')
+    dir += '/';
+  if(tools::mkpath(dir) != 0)
+    return "";
+  // everything that can change the generated binary goes into the key
+  std::ostringstream oss;
+  oss << preheader() << src << '\0';
+  std::map<std::string, std::string> defines(opt.defines.begin(), opt.defines.end());
+  for(const auto& x: defines)
+    oss << x.first << '=' << x.second << '\0';
+  oss << "num_warps=" << opt.num_warps << '\0';
+  if(dev_->backend() == driver::CUDA){
+    int version;
+    driver::dispatch::cuDriverGetVersion(&version);
+    oss << "cuda-sm_" << ((driver::cu_device*)dev_)->compute_capability() << "-" << version;
+  }
+  else{
+    llvm::StringMap<bool> features;
+    llvm::sys::getHostCPUFeatures(features);
+    std::map<std::string, bool> sorted;
+    for(const auto& f: features)
+      sorted[f.first().str()] = f.second;
+    oss << llvm::sys::getProcessTriple() << "-" << llvm::sys::getHostCPUName().str();
+    for(const auto& f: sorted)
+      oss << (f.second ? "+" : "-") << f.first;
+  }
+  // rebuilding the compiler from different sources invalidates the cache
+#ifdef TRITON_BUILD_ID
+  oss << '\0' << LLVM_VERSION_STRING << '\0' << TRITON_BUILD_ID;
+#endif
+  std::string key = oss.str();
+  unsigned char hash[20];
+  char hex[41];
+  sha1::calc(key.data(), key.size(), hash);
+  sha1::toHexString(hash, hex);
+  return dir + hex;
+}
+
+bool kernel::load_from_cache(const std::string& path) {
+  std::ifstream ifs(path, std::ios::binary);
+  if(!ifs)
+    return false;
+  try{
+    auto read_str = [&](std::string& str) {
+      uint64_t size = 0;
+      ifs.read((char*)&size, sizeof(size));
+      str.resize(ifs ? size : 0);
+      ifs.read(&str[0], str.size());
+    };
+    std::string name, sig, names, bin;
+    read_str(name);
+    read_str(sig);
+    read_str(names);
+    read_str(bin);
+    if(!ifs || name.empty())
+      throw std::runtime_error("truncated cache entry");
+    name_ = name;
+    for(char c: sig)
+      sig_.push_back((arg_type)c);
+    std::istringstream iss(names);
+    for(std::string arg; std::getline(iss, arg); )
+      arg_names_.push_back(arg);
+    pm_.run("cache-load", [&]() { mod_.reset(driver::module::create(dev_, bin)); });
+    ker_.reset(driver::kernel::create(&*mod_, name_.c_str()));
+  }catch(const std::exception&){
+    // unreadable or incompatible entry: forget it and recompile
+    name_.clear();
+    sig_.clear();
+    arg_names_.clear();
+    ker_.reset();
+    mod_.reset();
+    ifs.close();
+    std::remove(path.c_str());
+    return false;
+  }
+  init_ptr_offsets();
+  return true;
+}
+
+void kernel::save_to_cache(const std::string& path) const {
+  std::string sig(sig_.begin(), sig_.end());
+  std::string names;
+  for(const std::string& arg: arg_names_)
+    names += arg + "\n";
+  // write to a private file then rename, so that concurrent
+  // processes never observe a partially written entry
+  std::string tmp = path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream ofs(tmp, std::ios::binary);
+    auto write_str = [&](const std::string& str) {
+      uint64_t size = str.size();
+      ofs.write((const char*)&size, sizeof(size));
+      ofs.write(str.data(), size);
+    };
+    write_str(name_);
+    write_str(sig);
+    write_str(names);
+    write_str(mod_->binary());
+    if(!ofs){
+      std::remove(tmp.c_str());
+      return;
+    }
+  }
+  if(std::rename(tmp.c_str(), path.c_str()) != 0)
+    std::remove(tmp.c_str());
+}
+
+kernel::kernel(const std::string& src, const options_t& opt, driver::device *dev, frontend* fe):
   opt(opt), dev_(dev) {
-  init_ir(preheader() + src);
+  std::string path = cache_path(src);
+  if(!path.empty() && load_from_cache(path))
+    return;
+  init_ir(preheader() + src, fe);
   init_ker();
   init_sig();
+  init_ptr_offsets();
+  if(!path.empty())
+    save_to_cache(path);
+}
+
+kernel::kernel(std::shared_ptr<driver::module> mod, const std::string& entry, const std::vector<arg_type>& sig,
+               const std::vector<std::string>& arg_names, const options_t& opt, driver::device *dev):
+  opt(opt), dev_(dev), name_(entry), sig_(sig), arg_names_(arg_names), mod_(mod) {
+  ker_.reset(driver::kernel::create(&*mod_, name_.c_str()));
+  init_ptr_offsets();
 }
 
 void kernel::operator()(void *args, size_t args_size, driver::stream *stream, const std::vector<size_t>& _grid) const{
@@ -228,6 +352,49 @@ void kernel::operator()(void *args, size_t args_size, driver::stream *stream, co
 /* --------------------------------- */
 /* --------------------------------- */
 
+frontend::frontend(const std::string& src, const options_space_t& opt):
+  src_(kernel::preheader() + src), processed_(false) {
+  for(const auto& x: opt.defines){
+    if(x.second.size() > 1)
+      symbols_.push_back(x.first);
+    else if(x.second.size() == 1)
+      fixed_.push_back({x.first, x.second[0]});
+  }
+}
+
+bool frontend::specialize(TokenSequence& tokens, const options_t& opt) {
+  // pre-process on first use, so that nothing is done
+  // when all configurations are found in the cache
+  if(!processed_){
+    processed_ = true;
+    try{
+      std::shared_ptr<TokenSequence> ts(new TokenSequence());
+      Preprocessor cpp(&src_, true);
+      for(const std::string& x: symbols_)
+        cpp.AddSymbol(x);
+      for(auto& x: fixed_)
+        cpp.AddMacro(x.first, &x.second);
+      cpp.Process(*ts);
+      tokens_ = ts;
+    }catch(const SymbolicMacroError&){ }
+  }
+  if(!tokens_)
+    return false;
+  std::map<std::string, const std::string*> values;
+  for(const std::string& x: symbols_)
+    values[x] = &opt.defines.at(x);
+  try{
+    Preprocessor::Specialize(tokens, *tokens_, values);
+  }catch(const SymbolicMacroError&){
+    return false;
+  }
+  return true;
+}
+
+/* --------------------------------- */
+/* --------------------------------- */
+/* --------------------------------- */
+
 void function::do_loop_nest(std::vector<size_t> const & ranges,
                        std::function<void(std::vector<size_t> const &)> const & f){
   size_t D = ranges.size();
@@ -251,24 +418,57 @@ void function::init_kernels(const std::string& src, const options_space_t& opts,
   ranges.push_back(opts.num_warps.size());
   for(const auto& x: opts.defines)
     ranges.push_back(x.second.size());
-  // functor for source with given option
-  std::vector<std::pair<options_t, std::string>> err;
-  auto do_make = [&](std::vector<size_t> params) {
-    // compilation options
+  // enumerate configurations
+  std::vector<options_t> configs;
+  auto do_enumerate = [&](std::vector<size_t> params) {
     unsigned i = 0;
     options_t opt;
     opt.num_warps = opts.num_warps[params[i++]];
     for(auto D: opts.defines)
       opt.defines[D.first] = D.second[params[i++]];
-    // compile
+    configs.push_back(opt);
+  };
+  do_loop_nest(ranges, do_enumerate);
+  // worker threads must see the caller's CUDA context
+  CUcontext cu_ctx = nullptr;
+  if(device->backend() == driver::CUDA)
+    driver::dispatch::cuCtxGetCurrent(&cu_ctx);
+  // the source is pre-processed once for all configurations
+  frontend fe(src, opts);
+  // functor for source with given option
+  std::vector<std::shared_ptr<kernel>> compiled(configs.size());
+  std::vector<std::string> errors(configs.size());
+  auto do_make = [&](size_t i) {
+    if(cu_ctx)
+      driver::dispatch::cuCtxSetCurrent(cu_ctx);
     try{
-      kernels_.push_back({opt, std::make_shared<kernel>(src, opt, device)});
+      compiled[i] = std::make_shared<kernel>(src, configs[i], device, &fe);
     }catch(const exception::base& e){
-      err.push_back({opt, e.what()});
+      errors[i] = e.what();
     }
   };
   // multi-threaded compilation
-  do_loop_nest(ranges, do_make);
+  size_t num_threads = std::min<size_t>(configs.size(), std::thread::hardware_concurrency());
+  if(num_threads <= 1)
+    for(size_t i = 0; i < configs.size(); i++)
+      do_make(i);
+  else{
+    ThreadPool pool(num_threads);
+    std::vector<std::future<void>> done;
+    for(size_t i = 0; i < configs.size(); i++)
+      done.push_back(pool.enqueue(do_make, i));
+    // re-throws errors other than invalid configurations
+    for(std::future<void>& x: done)
+      x.get();
+  }
+  // keep enumeration order so that ties are resolved deterministically
+  std::vector<std::pair<options_t, std::string>> err;
+  for(size_t i = 0; i < configs.size(); i++){
+    if(compiled[i])
+      kernels_.push_back({configs[i], compiled[i]});
+    else
+      err.push_back({configs[i], errors[i]});
+  }
   if(kernels_.empty()){
     std::ostringstream dbg;
     dbg << "Auto-Tuner could not find any valid configuration:" << std::endl;
@@ -284,16 +484,78 @@ void function::init_kernels(const std::string& src, const options_space_t& opts,
   }
 }
 
+void function::init_bundle(const std::string& path, const std::string& name, driver::device *device) {
+  if(device->backend() != driver::Host)
+    throw std::runtime_error("bundles compiled by triton-cc only support the host");
+  // like JIT-compiled modules, bundles stay loaded until the process exits
+  void* lib = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if(!lib)
+    throw std::runtime_error("cannot load bundle " + path + ": " + dlerror());
+  const char* str = (const char*)dlsym(lib, bundle_t::symbol(name).c_str());
+  if(!str)
+    throw std::runtime_error("bundle " + name + " not found in " + path);
+  bundle_t bundle = bundle_t::parse(str);
+  for(const bundle_t::config_t& x: bundle.configs){
+    std::shared_ptr<driver::module> mod(new driver::host_module(lib, x.entry));
+    kernels_.push_back({x.opt, std::make_shared<kernel>(mod, x.entry, bundle.sig, bundle.arg_names, x.opt, device)});
+  }
+}
+
+std::vector<uint64_t> function::autotune_key(void* args, size_t args_size) const {
+  // arguments are packed with their natural alignment
+  const std::vector<arg_type>& sig = kernels_[0].second->get_sig();
+  std::vector<uint64_t> key;
+  size_t offset = 0;
+  for(arg_type ty: sig){
+    size_t size = size_of(ty);
+    offset = (offset + size - 1) / size * size;
+    if(offset + size > args_size)
+      break;
+    const char* ptr = (const char*)args + offset;
+    offset += size;
+    // integers: (bucketed) value
+    if(is_int_type(ty)){
+      int64_t val = 0;
+      switch(ty){
+        case INT1_T:
+        case INT8_T:  val = *(const int8_t*)ptr; break;
+        case INT16_T: val = *(const int16_t*)ptr; break;
+        case INT32_T: val = *(const int32_t*)ptr; break;
+        default:      val = *(const int64_t*)ptr; break;
+      }
+      if(bucket_ == BUCKET_POW2 && val > 0){
+        uint64_t pow2 = 1;
+        while(pow2 < (uint64_t)val)
+          pow2 <<= 1;
+        val = pow2;
+      }
+      key.push_back(val);
+    }
+    // pointers: alignment class, up to 16 bytes
+    if(ty == BUFFER_T){
+      uint64_t addr;
+      std::memcpy(&addr, ptr, sizeof(addr));
+      uint64_t align = 1;
+      while(align < 16 && addr % (align*2) == 0)
+        align *= 2;
+      key.push_back(align);
+    }
+  }
+  return key;
+}
+
 kernel* function::autotune(void* args, size_t args_size, const grid_fn_ty& grid_fn, driver::stream* stream) {
   // fast path -- no autotuning necessary
   if(kernels_.size() == 1)
     return &*kernels_.begin()->second;
   // auto-tuning key
-  std::vector<uint64_t> key;
+  std::vector<uint64_t> key = autotune_key(args, args_size);
   auto it = cache_.find(key);
   if(it != cache_.end())
     return it->second;
-  // run auto-tuner
+  // run auto-tuner; configurations are compared by median time,
+  // and dropped early when none of their first runs beats the best median
+  tools::benchmark bench(stream);
   double best_ts = INFINITY;
   kernel* ret = nullptr;
   for(auto &x : kernels_){
@@ -301,20 +563,35 @@ kernel* function::autotune(void* args, size_t args_size, const grid_fn_ty& grid_
     auto grid = grid_fn(x.first);
     while(grid.size() < 3)
       grid.push_back(1);
-    double ts = tools::bench([&]() { (*current)(args, args_size, stream, grid); },
-                                     stream, true);
-    ret = (ts < best_ts) ? current : ret;
-    best_ts = std::min(ts, best_ts);
+    tools::bench_result_t res = bench([&]() { (*current)(args, args_size, stream, grid); }, best_ts);
+    if(res.eliminated || res.median() >= best_ts)
+      continue;
+    ret = current;
+    best_ts = res.median();
   }
   stream->synchronize();
   it = cache_.insert({key, ret}).first;
   return it->second;
 }
 
-function::function(const std::string& src, const options_space_t& opt, driver::device *device) {
+std::vector<function::compile_stats_t> function::get_compile_stats() const {
+  std::vector<compile_stats_t> result;
+  for(const kernel_pair_t& x: kernels_)
+    result.push_back({x.first.to_str(), x.second->get_compile_stats()});
+  return result;
+}
+
+function::function(const std::string& src, const options_space_t& opt, driver::device *device):
+  bucket_(opt.bucket) {
   init_kernels(src, opt, device);
 }
 
+function::function(const std::string& path, const std::string& name, driver::device *device,
+                   autotune_bucket_t bucket):
+  bucket_(bucket) {
+  init_bundle(path, name, device);
+}
+
 void function::operator()(void* args, size_t args_size, const grid_fn_ty& grid_fn, driver::stream *stream) {
   runtime::kernel* fn = autotune(args, args_size, grid_fn, stream);
   (*fn)(args, args_size, stream, grid_fn(fn->opt));
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include "triton/runtime/launcher.h"
+
+namespace triton{
+namespace runtime{
+
+/* --------------------------------- */
+// Grid expressions                  //
+/* --------------------------------- */
+
+static bool is_integer(const std::string& str) {
+  char* end;
+  errno = 0;
+  std::strtoll(str.c_str(), &end, 0);
+  return !str.empty() && *end == '\0' && errno == 0;
+}
+
+// recursive descent into reverse polish notation
+launcher::expr_t launcher::compile(const std::string& str) {
+  expr_t ret;
+  size_t pos = 0;
+  auto error = [&](const std::string& msg) {
+    throw std::runtime_error("grid expression '" + str + "': " + msg);
+  };
+  auto skip = [&]() {
+    while(pos < str.size() && std::isspace(str[pos]))
+      pos++;
+  };
+  auto peek = [&]() {
+    skip();
+    return pos < str.size() ? str[pos] : '\0';
+  };
+  auto expect = [&](char c) {
+    if(peek() != c)
+      error(std::string("expected '") + c + "'");
+    pos++;
+  };
+  std::function<void()> expr, term, unary;
+  unary = [&]() {
+    char c = peek();
+    if(c == '-'){
+      pos++;
+      unary();
+      ret.push_back({op_t::NEG, 0});
+    }
+    else if(c == '('){
+      pos++;
+      expr();
+      expect(')');
+    }
+    else if(std::isdigit(c)){
+      size_t len;
+      int64_t val = std::stoll(str.substr(pos), &len);
+      pos += len;
+      ret.push_back({op_t::CONST, val});
+    }
+    else if(std::isalpha(c) || c == '_'){
+      size_t begin = pos;
+      while(pos < str.size() && (std::isalnum(str[pos]) || str[pos] == '_'))
+        pos++;
+      std::string name = str.substr(begin, pos - begin);
+      if(peek() == '('){
+        op_t::code_t code;
+        if(name == "cdiv")     code = op_t::CDIV;
+        else if(name == "min") code = op_t::MIN;
+        else if(name == "max") code = op_t::MAX;
+        else error("unknown function " + name);
+        pos++;
+        expr();
+        expect(',');
+        expr();
+        expect(')');
+        ret.push_back({code, 0});
+        return;
+      }
+      // arguments of the kernel shadow defines
+      auto it = std::find(names_.begin(), names_.end(), name);
+      if(it != names_.end()){
+        size_t i = it - names_.begin();
+        if(!is_int_type(sig_[i]))
+          error("argument " + name + " is not an integer");
+        ret.push_back({op_t::ARG, (int64_t)i});
+        return;
+      }
+      auto jt = std::find(defines_.begin(), defines_.end(), name);
+      if(jt == defines_.end()){
+        // every configuration must give the define an integer value
+        for(const function::kernel_pair_t& x: fn_->get_kernels()){
+          auto kt = x.first.defines.find(name);
+          if(kt == x.first.defines.end())
+            error(name + " is neither an argument nor a define");
+          if(!is_integer(kt->second))
+            error("define " + name + " is not an integer");
+        }
+        defines_.push_back(name);
+        define_vals_.clear();
+        jt = defines_.end() - 1;
+      }
+      ret.push_back({op_t::DEFINE, jt - defines_.begin()});
+    }
+    else
+      error("unexpected character");
+  };
+  term = [&]() {
+    unary();
+    for(char c = peek(); c == '*' || c == '/' || c == '%'; c = peek()){
+      pos++;
+      unary();
+      ret.push_back({c == '*' ? op_t::MUL : c == '/' ? op_t::DIV : op_t::MOD, 0});
+    }
+  };
+  expr = [&]() {
+    term();
+    for(char c = peek(); c == '+' || c == '-'; c = peek()){
+      pos++;
+      term();
+      ret.push_back({c == '+' ? op_t::ADD : op_t::SUB, 0});
+    }
+  };
+  expr();
+  if(peek() != '\0')
+    error("unexpected trailing characters");
+  return ret;
+}
+
+int64_t launcher::get_int(size_t i) const {
+  const char* ptr = (const char*)buf_.data() + offsets_[i];
+  switch(sig_[i]){
+    case INT1_T:
+    case INT8_T:  return *(const int8_t*)ptr;
+    case INT16_T: return *(const int16_t*)ptr;
+    case INT32_T: return *(const int32_t*)ptr;
+    default:      return *(const int64_t*)ptr;
+  }
+}
+
+const std::vector<int64_t>& launcher::get_defines(const options_t& opt) {
+  auto it = define_vals_.find(&opt);
+  if(it != define_vals_.end())
+    return it->second;
+  std::vector<int64_t> vals;
+  for(const std::string& name: defines_){
+    auto jt = opt.defines.find(name);
+    if(jt == opt.defines.end())
+      throw std::runtime_error("grid expression uses " + name + ", which is neither an argument nor a define");
+    vals.push_back(std::stoll(jt->second));
+  }
+  return define_vals_[&opt] = vals;
+}
+
+int64_t launcher::eval(const expr_t& expr, const options_t& opt) {
+  int64_t stack[32];
+  size_t n = 0;
+  const std::vector<int64_t>* defines = nullptr;
+  for(const op_t& op: expr){
+    int64_t a = n >= 2 ? stack[n - 2] : 0;
+    int64_t b = n >= 1 ? stack[n - 1] : 0;
+    if((op.code == op_t::DIV || op.code == op_t::MOD || op.code == op_t::CDIV) && b == 0)
+      throw std::runtime_error("division by zero in grid expression");
+    switch(op.code){
+      case op_t::CONST:  stack[n++] = op.val; break;
+      case op_t::ARG:    stack[n++] = get_int(op.val); break;
+      case op_t::DEFINE:
+        if(!defines)
+          defines = &get_defines(opt);
+        stack[n++] = (*defines)[op.val];
+        break;
+      case op_t::NEG:    stack[n - 1] = -b; break;
+      case op_t::ADD:    stack[--n - 1] = a + b; break;
+      case op_t::SUB:    stack[--n - 1] = a - b; break;
+      case op_t::MUL:    stack[--n - 1] = a * b; break;
+      case op_t::DIV:    stack[--n - 1] = a / b; break;
+      case op_t::MOD:    stack[--n - 1] = a % b; break;
+      case op_t::CDIV:   stack[--n - 1] = (a + b - 1) / b; break;
+      case op_t::MIN:    stack[--n - 1] = std::min(a, b); break;
+      case op_t::MAX:    stack[--n - 1] = std::max(a, b); break;
+    }
+  }
+  return stack[0];
+}
+
+/* --------------------------------- */
+// Launcher                          //
+/* --------------------------------- */
+
+launcher::launcher(function* fn): fn_(fn) {
+  const kernel& ker = *fn->get_kernels()[0].second;
+  sig_ = ker.get_sig();
+  names_ = ker.get_arg_names();
+  // natural alignment, as in the entry points of the host and in
+  // the parameter buffer of cuLaunchKernel
+  size_t offset = 0;
+  for(arg_type ty: sig_){
+    size_t size = size_of(ty);
+    offset = (offset + size - 1) / size * size;
+    offsets_.push_back(offset);
+    offset += size;
+  }
+  size_ = offset;
+  buf_.resize((size_ + 7) / 8);
+}
+
+size_t launcher::add_grid(const std::vector<std::string>& grid) {
+  if(grid.empty() || grid.size() > 3)
+    throw std::runtime_error("grids must have between 1 and 3 dimensions");
+  std::vector<expr_t> exprs;
+  // defines used only by a rejected grid are forgotten
+  size_t num_defines = defines_.size();
+  try{
+    for(const std::string& x: grid){
+      exprs.push_back(compile(x));
+      size_t depth = 0, max_depth = 0;
+      for(const op_t& op: exprs.back()){
+        bool push = op.code == op_t::CONST || op.code == op_t::ARG || op.code == op_t::DEFINE;
+        bool unary = op.code == op_t::NEG;
+        depth = push ? depth + 1 : unary ? depth : depth - 1;
+        max_depth = std::max(max_depth, depth);
+      }
+      if(max_depth > 32)
+        throw std::runtime_error("grid expression '" + x + "' is too deeply nested");
+    }
+  }catch(...){
+    if(defines_.size() != num_defines){
+      defines_.resize(num_defines);
+      define_vals_.clear();
+    }
+    throw;
+  }
+  grids_.push_back(exprs);
+  return grids_.size() - 1;
+}
+
+void launcher::clear_grids() {
+  grids_.clear();
+  defines_.clear();
+  define_vals_.clear();
+}
+
+void launcher::operator()(size_t grid, driver::stream* stream) {
+  const std::vector<expr_t>& exprs = grids_.at(grid);
+  auto grid_fn = [&](const options_t& opt) {
+    grid_t ret(3, 1);
+    for(size_t d = 0; d < exprs.size(); d++)
+      ret[d] = eval(exprs[d], opt);
+    return ret;
+  };
+  (*fn_)(buf_.data(), size_, grid_fn, stream);
+}
+
+}
+}
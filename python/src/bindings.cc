@@ -5,6 +5,7 @@
 #include <string>
 #include "triton/driver/stream.h"
 #include "triton/runtime/function.h"
+#include "triton/runtime/launcher.h"
 #include "triton/runtime/arg.h"
 #include "triton/lang/code_gen.h"
 #include "triton/lang/parser.h"
@@ -20,6 +21,7 @@ typedef std::pair<int, int> map_key_t;
 
 std::map<map_key_t, std::shared_ptr<rt::function::grid_fn_ty>> id_grid_map;
 std::map<int, std::shared_ptr<rt::function>> id_fn_map;
+std::map<int, std::shared_ptr<rt::launcher>> id_launcher_map;
 std::map<int, std::shared_ptr<triton::driver::device>> tt_devices;
 std::map<int, std::shared_ptr<triton::driver::stream>> tt_streams;
 std::unordered_map<const rt::options_t*, pybind11::object> opt_cache_;
@@ -73,12 +75,14 @@ void register_fn(int op_id,
 }
 
 void delete_fn(int op_id) {
+  id_launcher_map.erase(op_id);
   id_fn_map.erase(op_id);
 }
 
 
 void cleanup() {
   id_grid_map.clear();
+  id_launcher_map.clear();
   id_fn_map.clear();
   opt_cache_.clear();
 }
@@ -114,7 +118,27 @@ pybind11::object autotune(int64_t op_id, int64_t dev_id, const std::string& args
 }
 
 
+/* Compilation statistics */
+
+std::vector<rt::function::compile_stats_t> get_compile_stats(int64_t op_id) {
+  return id_fn_map.at(op_id)->get_compile_stats();
+}
+
+std::string get_compile_stats_json(int64_t op_id) {
+  std::string result = "{";
+  auto stats = get_compile_stats(op_id);
+  for(size_t i = 0; i < stats.size(); i++)
+    result += (i ? ", \"" : "\"") + codegen::escape(stats[i].first) + "\": " + codegen::to_json(stats[i].second);
+  return result + "}";
+}
+
+std::string get_compile_trace(int64_t op_id) {
+  return codegen::to_chrome_trace(get_compile_stats(op_id));
+}
+
 void init_superblocking(pybind11::module &m);
+void init_conv(pybind11::module &m);
+void init_blocksparse(pybind11::module &m);
 void init_launch(pybind11::module &m);
 
 PYBIND11_MODULE(libtriton, m) {
@@ -136,6 +160,10 @@ PYBIND11_MODULE(libtriton, m) {
         .value("ptx" , rt::ASM_NV_PTX)
         .value("sass", rt::ASM_NV_SASS);
 
+    pybind11::enum_<rt::autotune_bucket_t>(m, "autotune_bucket")
+        .value("exact", rt::BUCKET_EXACT)
+        .value("pow2" , rt::BUCKET_POW2);
+
     pybind11::class_<rt::options_t>(m, "options", pybind11::dynamic_attr())
         .def_readwrite("num_warps", &rt::options_t::num_warps)
         .def_readwrite("defines"  , &rt::options_t::defines);
@@ -143,7 +171,15 @@ PYBIND11_MODULE(libtriton, m) {
     pybind11::class_<rt::options_space_t>(m, "options_space")
         .def(pybind11::init<>())
         .def_readwrite("num_warps", &rt::options_space_t::num_warps)
-        .def_readwrite("defines"  , &rt::options_space_t::defines);
+        .def_readwrite("defines"  , &rt::options_space_t::defines)
+        .def_readwrite("bucket"   , &rt::options_space_t::bucket);
+
+    pybind11::class_<codegen::pass_stat_t>(m, "pass_stat")
+        .def_readonly("name"            , &codegen::pass_stat_t::name)
+        .def_readonly("start_us"        , &codegen::pass_stat_t::start_us)
+        .def_readonly("time_us"         , &codegen::pass_stat_t::time_us)
+        .def_readonly("num_insts_before", &codegen::pass_stat_t::num_insts_before)
+        .def_readonly("num_insts_after" , &codegen::pass_stat_t::num_insts_after);
 
     // hooks into triton constructs since frameworks may not use pybind11
     m.def("get_fn_signature", &get_fn_signature);
@@ -156,7 +192,12 @@ PYBIND11_MODULE(libtriton, m) {
     m.def("cleanup", &cleanup);
     m.def("autotune", &autotune, pybind11::return_value_policy::reference);
     m.def("launch_kernel", &launch_kernel);
+    m.def("get_compile_stats", &get_compile_stats);
+    m.def("get_compile_stats_json", &get_compile_stats_json);
+    m.def("get_compile_trace", &get_compile_trace);
 
     init_launch(m);
     init_superblocking(m);
+    init_conv(m);
+    init_blocksparse(m);
 }
@@ -0,0 +1,254 @@
+#include <torch/extension.h>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef std::vector<std::tuple<int, torch::Tensor>> ret_t;
+ret_t superblock(torch::Tensor layout, int start_width);
+
+/* Load-balancing */
+
+// reductions of a head are split into segments of at most
+// `seg_max` blocks; heuristics taken from OpenAI blocksparse:
+// https://github.com/openai/blocksparse/blob/master/blocksparse/matmul.py#L95
+struct balance_t {
+  int64_t seg_max;
+  int64_t seg_min;
+  // number of segments of a reduction of `size` blocks
+  int64_t num_segments(int64_t size) const {
+    int64_t d = size / seg_max, r = size % seg_max;
+    return d + (size < seg_min) + (r >= seg_min);
+  }
+};
+
+static balance_t make_balance(const int64_t* sizes, int64_t n) {
+  int64_t max_size = n ? *std::max_element(sizes, sizes + n) : 0;
+  balance_t ret;
+  // heads without any block get one empty segment per reduction
+  ret.seg_max = std::max<int64_t>(max_size, 1);
+  ret.seg_min = std::max<int64_t>((ret.seg_max + 3) / 4, 4);
+  return ret;
+}
+
+/* Look-up tables */
+
+// look-up table of dense = dense x sparse and dense = sparse x dense products;
+// reductions run along the rows of `layout` when `trans` is set, along its columns otherwise
+//   header: (offset, size, column, depth, lock id, number of segments sharing the lock) per segment
+//   increments: (a, b) pointer increments per step of every block, followed by (0, 0)
+static std::tuple<std::vector<int32_t>, int64_t, int64_t> dxx_lut(const int32_t* layout, int64_t Z, int64_t M, int64_t N,
+                                                                  int64_t block, int64_t step, bool trans) {
+  // reduction `c` of head `z` visits blocks (z, i, j) in the order of `k`
+  int64_t C = trans ? M : N;
+  int64_t L = trans ? N : M;
+  auto at = [&](int64_t z, int64_t c, int64_t k) { return trans ? layout[(z*M + c)*N + k] : layout[(z*M + k)*N + c]; };
+  // reduction sizes
+  std::vector<int64_t> sizes(Z*C, 0);
+  #ifdef _OPENMP
+  #pragma omp parallel for collapse(2)
+  #endif
+  for(int64_t z = 0; z < Z; z++)
+  for(int64_t c = 0; c < C; c++)
+    for(int64_t k = 0; k < L; k++)
+      sizes[z*C + c] += at(z, c, k) != 0;
+  // segments and blocks before every reduction
+  std::vector<balance_t> balance(Z);
+  std::vector<int64_t> seg_start(Z*C + 1, 0), blk_start(Z*C + 1, 0);
+  for(int64_t z = 0; z < Z; z++){
+    balance[z] = make_balance(&sizes[z*C], C);
+    for(int64_t c = 0; c < C; c++){
+      seg_start[z*C + c + 1] = seg_start[z*C + c] + balance[z].num_segments(sizes[z*C + c]);
+      blk_start[z*C + c + 1] = blk_start[z*C + c] + sizes[z*C + c];
+    }
+  }
+  int64_t width = seg_start[Z*C];
+  int64_t num_blocks = blk_start[Z*C];
+  // reductions split in several segments synchronize with locks,
+  // numbered from 1 across heads
+  std::vector<int64_t> lock_start(Z*C + 1, 0);
+  for(int64_t zc = 0; zc < Z*C; zc++){
+    const balance_t& b = balance[zc / C];
+    int64_t d = sizes[zc] / b.seg_max, r = sizes[zc] % b.seg_max;
+    lock_start[zc + 1] = lock_start[zc] + (d > 1 || (d == 1 && r >= b.seg_min));
+  }
+  int64_t num_locks = std::max<int64_t>(lock_start[Z*C], 1);
+  // position of every block in its head, in row-major order
+  std::vector<int64_t> rank;
+  if(!trans){
+    rank.resize(Z*M*N);
+    std::vector<int64_t> row_start(Z*M + 1, 0);
+    for(int64_t zm = 0; zm < Z*M; zm++)
+      row_start[zm + 1] = row_start[zm] + std::count_if(layout + zm*N, layout + (zm + 1)*N, [](int32_t x) { return x != 0; });
+    #ifdef _OPENMP
+    #pragma omp parallel for
+    #endif
+    for(int64_t zm = 0; zm < Z*M; zm++){
+      int64_t current = row_start[zm] - row_start[zm / M * M];
+      for(int64_t n = 0; n < N; n++)
+        rank[zm*N + n] = layout[zm*N + n] ? current++ : 0;
+    }
+  }
+  // blocks, in the order of the reductions
+  std::vector<int64_t> idx(num_blocks), widx(num_blocks);
+  #ifdef _OPENMP
+  #pragma omp parallel for collapse(2)
+  #endif
+  for(int64_t z = 0; z < Z; z++)
+  for(int64_t c = 0; c < C; c++){
+    int64_t current = blk_start[z*C + c];
+    for(int64_t k = 0; k < L; k++){
+      if(!at(z, c, k))
+        continue;
+      idx[current] = k*block;
+      widx[current] = trans ? current : blk_start[z*C] + rank[(z*M + k)*N + c];
+      current++;
+    }
+  }
+  // header
+  int64_t div = block / step;
+  std::vector<int32_t> lut(6*width + 2*num_blocks*div + 2, 0);
+  std::vector<int64_t> seg_offsets(width), seg_sizes(width);
+  #ifdef _OPENMP
+  #pragma omp parallel for collapse(2)
+  #endif
+  for(int64_t z = 0; z < Z; z++)
+  for(int64_t c = 0; c < C; c++){
+    const balance_t& b = balance[z];
+    int64_t zc = z*C + c;
+    int64_t size = sizes[zc];
+    int64_t d = size / b.seg_max, r = size % b.seg_max;
+    bool isempty = size < b.seg_min;
+    int64_t first = seg_start[zc], last = seg_start[zc + 1];
+    bool locked = lock_start[zc + 1] > lock_start[zc];
+    int64_t offset = blk_start[zc];
+    for(int64_t s = first; s < last; s++){
+      int64_t seg_size = s < first + d ? b.seg_max : r;
+      if(s == first + d - 1 && r < b.seg_min && !isempty)
+        seg_size += r;
+      seg_offsets[s] = std::min(offset, std::max<int64_t>(num_blocks - 1, 0));
+      seg_sizes[s] = seg_size;
+      int32_t* h = &lut[6*s];
+      h[0] = 6*width + seg_offsets[s]*2*div;
+      h[1] = seg_size*step*div;
+      h[2] = c;
+      h[3] = z;
+      h[4] = locked ? lock_start[zc + 1] : 0;
+      h[5] = locked ? last - first : 0;
+      offset += seg_size;
+    }
+  }
+  // increments; the first one of a segment is an absolute offset
+  int32_t* incs = &lut[6*width];
+  int64_t wstep = trans ? step : step*block;
+  #ifdef _OPENMP
+  #pragma omp parallel for
+  #endif
+  for(int64_t i = 0; i < num_blocks; i++){
+    int64_t xinc = idx[i] - (i ? idx[i - 1] : 0);
+    int64_t winc = (widx[i] - (i ? widx[i - 1] : 0))*block*block;
+    incs[2*i*div + 0] = xinc - (div - 1)*step;
+    incs[2*i*div + 1] = winc - (div - 1)*wstep;
+    for(int64_t s = 1; s < div; s++){
+      incs[2*(i*div + s) + 0] = step;
+      incs[2*(i*div + s) + 1] = wstep;
+    }
+  }
+  for(int64_t s = 0; s < width; s++){
+    if(seg_sizes[s] == 0)
+      continue;
+    int64_t i = seg_offsets[s];
+    incs[2*i*div + 0] = idx[i];
+    incs[2*i*div + 1] = widx[i];
+  }
+  return std::make_tuple(lut, num_locks, width);
+}
+
+/* Caching */
+
+// layers of a model often share their layout; tables are kept for the
+// lifetime of the process and looked up by a hash of the layout
+struct lut_key_t {
+  size_t hash;
+  std::vector<int64_t> params;
+  std::string device;
+  bool operator<(const lut_key_t& other) const {
+    return std::tie(hash, params, device) < std::tie(other.hash, other.params, other.device);
+  }
+};
+
+template<class T>
+struct lut_cache_t {
+  std::mutex mutex;
+  std::multimap<lut_key_t, std::pair<torch::Tensor, T>> entries;
+};
+
+static lut_key_t make_key(const torch::Tensor& layout, std::vector<int64_t> params, torch::Device device) {
+  const char* data = (const char*)layout.data_ptr();
+  size_t hash = std::hash<std::string>()(std::string(data, data + layout.numel()*layout.element_size()));
+  for(int64_t size: layout.sizes())
+    params.push_back(size);
+  return lut_key_t{hash, params, device.str()};
+}
+
+// returns the cached value for `layout` in `cache`, or the result of `make`
+template<class T>
+static T memoize(lut_cache_t<T>& cache, torch::Tensor layout, std::vector<int64_t> params,
+                 torch::Device device, std::function<T(torch::Tensor)> make) {
+  layout = layout.to(torch::kCPU, torch::kInt32).contiguous();
+  lut_key_t key = make_key(layout, params, device);
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto range = cache.entries.equal_range(key);
+  for(auto it = range.first; it != range.second; ++it)
+    if(torch::equal(it->second.first, layout))
+      return it->second.second;
+  T ret = make(layout);
+  // the caller may modify its layout afterwards
+  cache.entries.emplace(key, std::make_pair(layout.clone(), ret));
+  return ret;
+}
+
+typedef std::tuple<torch::Tensor, int64_t, int64_t> dxx_ret_t;
+typedef std::vector<std::tuple<torch::Tensor, int64_t, int64_t>> sdd_ret_t;
+
+static lut_cache_t<dxx_ret_t> dxx_cache;
+static lut_cache_t<sdd_ret_t> sdd_cache;
+
+// (look-up table, number of locks, grid width)
+dxx_ret_t make_dxx_lut(torch::Tensor layout, int64_t block, int64_t step, bool trans, torch::Device device) {
+  return memoize<dxx_ret_t>(dxx_cache, layout, {block, step, trans}, device, [&](torch::Tensor layout) {
+    std::vector<int32_t> lut;
+    int64_t num_locks, width;
+    std::tie(lut, num_locks, width) = dxx_lut(layout.data_ptr<int32_t>(), layout.size(0), layout.size(1), layout.size(2),
+                                              block, step, trans);
+    torch::Tensor ret = torch::from_blob(lut.data(), {(int64_t)lut.size()}, torch::kInt32).to(device, false, true);
+    return std::make_tuple(ret, num_locks, width);
+  });
+}
+
+// (look-up table, grid width, pack) for every size of super-block
+sdd_ret_t make_sdd_lut(torch::Tensor layout, int64_t block, torch::Device device) {
+  return memoize<sdd_ret_t>(sdd_cache, layout, {block}, device, [&](torch::Tensor layout) {
+    sdd_ret_t ret;
+    // super-blocking consumes the blocks of its input
+    for(auto& x: superblock(layout.clone(), 64 / block)){
+      int64_t size = std::get<0>(x);
+      torch::Tensor nnz = std::get<1>(x);
+      // (head, row, column, block index) per block
+      torch::Tensor lut = nnz.contiguous().view(-1).to(device, torch::kInt32);
+      ret.push_back(std::make_tuple(lut, nnz.size(0) / (size*size), size));
+    }
+    return ret;
+  });
+}
+
+void init_blocksparse(pybind11::module &m) {
+  m.def("make_dxx_lut", &make_dxx_lut, "look-up table for dense = dense x sparse and dense = sparse x dense products");
+  m.def("make_sdd_lut", &make_sdd_lut, "look-up tables for sparse = dense x dense products");
+}
@@ -0,0 +1,57 @@
+#include <torch/extension.h>
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// (device, CI, R, S, stride of A along CI, H and W, TK)
+typedef std::tuple<std::string, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t> delta_key_t;
+
+// at most `max_deltas` tables are kept, least recently used first out
+static const size_t max_deltas = 64;
+static std::list<delta_key_t> delta_lru;
+static std::map<delta_key_t, std::pair<torch::Tensor, std::list<delta_key_t>::iterator>> delta_cache;
+static std::mutex delta_mutex;
+
+// pointer increments of A when the reduction index k = (ci, r, s)
+// moves from k to k + TK; padded to a multiple of TK, since the
+// last iteration of the kernel reads a full tile of increments
+torch::Tensor conv_delta(int64_t CI, int64_t R, int64_t S,
+                         int64_t lda_ci, int64_t lda_h, int64_t lda_w,
+                         int64_t TK, torch::Device device) {
+  delta_key_t key(device.str(), CI, R, S, lda_ci, lda_h, lda_w, TK);
+  std::lock_guard<std::mutex> lock(delta_mutex);
+  auto it = delta_cache.find(key);
+  if(it != delta_cache.end()){
+    delta_lru.splice(delta_lru.begin(), delta_lru, it->second.second);
+    return it->second.first;
+  }
+  int64_t K = CI*R*S;
+  int64_t size = (K + TK - 1) / TK * TK;
+  std::vector<int32_t> delta(size);
+  auto unpack = [&](int64_t k, int64_t& ci, int64_t& r, int64_t& s) {
+    s  = k % S;
+    r  = (k / S) % R;
+    ci = k / (S*R);
+  };
+  for(int64_t k = 0; k < size; k++){
+    int64_t ci, r, s, nci, nr, ns;
+    unpack(k, ci, r, s);
+    unpack(k + TK, nci, nr, ns);
+    delta[k] = (nci - ci)*lda_ci + (nr - r)*lda_h + (ns - s)*lda_w;
+  }
+  // copy, since `delta` goes away and `to` does nothing on the host
+  torch::Tensor ret = torch::from_blob(delta.data(), {size}, torch::kInt32).to(device, false, true);
+  if(delta_cache.size() == max_deltas){
+    delta_cache.erase(delta_lru.back());
+    delta_lru.pop_back();
+  }
+  delta_lru.push_front(key);
+  delta_cache.emplace(key, std::make_pair(ret, delta_lru.begin()));
+  return ret;
+}
+
+void init_conv(pybind11::module &m) {
+  m.def("conv_delta", &conv_delta, "look-up table of pointer increments for convolutions");
+}
@@ -6,9 +6,12 @@
 #include <pybind11/functional.h>
 #include "triton/driver/buffer.h"
 #include "triton/driver/stream.h"
+#include "triton/driver/event.h"
 #include "triton/runtime/function.h"
+#include "triton/runtime/launcher.h"
 #include "triton/tools/bench.hpp"
 #include "torch/script.h"
+#include "torch/csrc/autograd/python_variable.h"
 #include "ATen/cuda/CUDAContext.h"
 #include <c10/cuda/CUDAException.h>
 #include <cuda_runtime_api.h>
@@ -22,6 +25,7 @@ extern std::map<map_key_t, std::shared_ptr<rt::function::grid_fn_ty>> id_grid_ma
 extern std::map<int, std::shared_ptr<rt::function>> id_fn_map;
 extern std::map<int, std::shared_ptr<drv::device>> tt_devices;
 extern std::map<int, std::shared_ptr<drv::stream>> tt_streams;
+extern std::map<int, std::shared_ptr<rt::launcher>> id_launcher_map;
 
 
 int64_t cdiv(int64_t a, int64_t b) {
@@ -72,6 +76,118 @@ void cuda_set_device(int64_t dev_id) {
     C10_CUDA_CHECK(cudaSetDevice(dev_id));
 }
 
+/* Native launches */
+
+static rt::launcher* get_launcher(int64_t op_id) {
+  std::shared_ptr<rt::launcher>& ret = id_launcher_map[op_id];
+  if(!ret)
+    ret.reset(new rt::launcher(id_fn_map.at(op_id).get()));
+  return ret.get();
+}
+
+size_t register_grid_expr(int64_t op_id, const std::vector<std::string>& grid) {
+  return get_launcher(op_id)->add_grid(grid);
+}
+
+void clear_grid_exprs(int64_t op_id) {
+  get_launcher(op_id)->clear_grids();
+}
+
+// writes the arguments straight into the buffer of the launcher,
+// without going through struct.pack and std::string
+void launch(int64_t op_id, int64_t dev_id, size_t grid, pybind11::args args) {
+  rt::launcher* launcher = get_launcher(op_id);
+  if(args.size() != launcher->num_args())
+    throw pybind11::type_error("expected " + std::to_string(launcher->num_args()) +
+                               " arguments but got " + std::to_string(args.size()));
+  for(size_t i = 0; i < args.size(); i++){
+    PyObject* obj = args[i].ptr();
+    char* dst = launcher->arg(i);
+    switch(launcher->type(i)){
+      // a tensor, or an address such as x.data_ptr()
+      case rt::BUFFER_T: {
+        void* ptr;
+        if(THPVariable_Check(obj))
+          ptr = THPVariable_Unpack(obj).data_ptr();
+        else if(PyLong_Check(obj))
+          ptr = PyLong_AsVoidPtr(obj);
+        else
+          throw pybind11::type_error("argument " + std::to_string(i) + " must be a tensor or an address");
+        std::memcpy(dst, &ptr, sizeof(ptr));
+        break;
+      }
+      case rt::FLOAT_T:  *(float*)dst = PyFloat_AsDouble(obj); break;
+      case rt::DOUBLE_T: *(double*)dst = PyFloat_AsDouble(obj); break;
+      // bits of the IEEE half, as with struct.pack('H')
+      case rt::HALF_T:   *(uint16_t*)dst = PyLong_AsLong(obj); break;
+      case rt::INT1_T:
+      case rt::INT8_T:   *(int8_t*)dst = PyLong_AsLong(obj); break;
+      case rt::INT16_T:  *(int16_t*)dst = PyLong_AsLong(obj); break;
+      case rt::INT32_T:  *(int32_t*)dst = PyLong_AsLong(obj); break;
+      case rt::INT64_T:  *(int64_t*)dst = PyLong_AsLongLong(obj); break;
+    }
+    if(PyErr_Occurred())
+      throw pybind11::error_already_set();
+  }
+  cuda_set_device(dev_id);
+  (*launcher)(grid, &*tt_streams[dev_id]);
+}
+
+/* Host streams, events and graphs */
+
+// stream that launches on the host are submitted to
+static std::shared_ptr<drv::host_stream> get_host_stream() {
+  auto it = tt_streams.find(-1);
+  if(it == tt_streams.end())
+    throw std::runtime_error("no kernel was created on the host");
+  return std::static_pointer_cast<drv::host_stream>(it->second);
+}
+
+// returns the stream that was used until now
+std::shared_ptr<drv::host_stream> set_host_stream(std::shared_ptr<drv::host_stream> stream) {
+  std::shared_ptr<drv::host_stream> ret = get_host_stream();
+  tt_streams[-1] = stream;
+  return ret;
+}
+
+// launches on the host are recorded between begin_capture and end_capture;
+// the graph outlives its replays, and any capture into it
+struct host_graph {
+  drv::host_graph graph;
+  std::shared_ptr<drv::host_stream> capture;
+  std::set<std::shared_ptr<drv::host_stream>> replays;
+
+  void begin_capture() {
+    if(capture)
+      throw std::runtime_error("graph is already capturing");
+    std::shared_ptr<drv::host_stream> stream = get_host_stream();
+    stream->begin_capture(&graph);
+    capture = stream;
+  }
+
+  void end_capture() {
+    if(!capture)
+      throw std::runtime_error("graph is not capturing");
+    capture->end_capture();
+    capture.reset();
+  }
+
+  void replay() {
+    if(capture)
+      throw std::runtime_error("cannot replay a graph during its capture");
+    std::shared_ptr<drv::host_stream> stream = get_host_stream();
+    stream->launch(&graph);
+    replays.insert(stream);
+  }
+
+  ~host_graph() {
+    if(capture)
+      capture->end_capture();
+    for(const auto& stream: replays)
+      stream->synchronize();
+  }
+};
+
 
 void init_launch(pybind11::module &m) {
   m.def("cuda_set_device", &cuda_set_device);
@@ -80,4 +196,40 @@ void init_launch(pybind11::module &m) {
   m.def("cdiv", &cdiv);
   m.def("cdiv_sum", &cdiv_sum);
   m.def("synchronize", &synchronize);
+  m.def("register_grid_expr", &register_grid_expr);
+  m.def("clear_grid_exprs", &clear_grid_exprs);
+  m.def("launch", &launch);
+
+  pybind11::class_<drv::stream, std::shared_ptr<drv::stream>>(m, "stream")
+      .def("synchronize", &drv::stream::synchronize)
+      .def("wait", &drv::stream::wait);
+
+  pybind11::class_<drv::host_stream, drv::stream, std::shared_ptr<drv::host_stream>>(m, "host_stream")
+      .def(pybind11::init<>());
+
+  pybind11::class_<drv::event, std::shared_ptr<drv::event>>(m, "event")
+      .def("record", &drv::event::record)
+      .def("query", &drv::event::query)
+      .def("synchronize", &drv::event::synchronize)
+      .def("elapsed_time", &drv::event::elapsed_time);
+
+  pybind11::class_<drv::host_event, drv::event, std::shared_ptr<drv::host_event>>(m, "host_event")
+      .def(pybind11::init<>());
+
+  m.def("get_host_stream", &get_host_stream);
+  m.def("set_host_stream", &set_host_stream);
+
+  pybind11::class_<host_graph>(m, "host_graph")
+      .def(pybind11::init<>())
+      .def("begin_capture", &host_graph::begin_capture)
+      .def("end_capture", &host_graph::end_capture)
+      .def("replay", &host_graph::replay)
+      .def("add_allocation", [](host_graph& self, size_t base, size_t size) {
+        self.graph.add_allocation((const void*)base, size);
+      })
+      .def("rebind", [](host_graph& self, size_t from, size_t to) {
+        self.graph.rebind((const void*)from, (const void*)to);
+      })
+      .def("num_launches", [](const host_graph& self) { return self.graph.num_launches(); })
+      .def("successors", [](const host_graph& self, size_t i) { return self.graph.successors(i); });
 }
\ No newline at end of file
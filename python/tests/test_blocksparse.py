@@ -23,14 +23,17 @@ def mask_tensor(x, mask, block, value = 0):
                           for block in [16, 32, 64]
     ]
 )
-def test_op(MODE, TRANS_A, TRANS_B, BLOCK, DTYPE = torch.float16, Z = 3, H = 2, M = 128, N = 256, K = 384):
+def test_op(MODE, TRANS_A, TRANS_B, BLOCK, DTYPE = torch.float16, Z = 3, H = 2, M = 128, N = 256, K = 384, make_layout = None):
   # set seed
   torch.random.manual_seed(0)
   # create inputs
   a = torch.randn((Z, H, K, M) if TRANS_A else (Z, H, M, K), dtype=DTYPE, device='cuda')
   b = torch.randn((Z, H, N, K) if TRANS_B else (Z, H, K, N), dtype=DTYPE, device='cuda')
   shape = {'sdd': (M, N), 'dsd': (a.shape[2], a.shape[3]), 'dds': (b.shape[2], b.shape[3])}[MODE]
-  layout = torch.randint(2, (H, shape[0]//BLOCK, shape[1]//BLOCK))
+  if make_layout is None:
+    layout = torch.randint(2, (H, shape[0]//BLOCK, shape[1]//BLOCK))
+  else:
+    layout = make_layout(H, shape[0]//BLOCK, shape[1]//BLOCK)
   # triton result
   op = tt.ops.blocksparse.matmul(layout, BLOCK, MODE, trans_a=TRANS_A, trans_b=TRANS_B)
   ra = sparsify_tensor(a, layout, BLOCK) if MODE == 'dsd' else a
@@ -48,3 +51,23 @@ def test_op(MODE, TRANS_A, TRANS_B, BLOCK, DTYPE = torch.float16, Z = 3, H = 2,
   rtol, atol = {torch.float32: (1e-4, 1e-5),
                 torch.float16: (1e-2, 1e-3)}[DTYPE]
   assert torch.allclose(rc, tc, rtol=rtol, atol=atol)
+
+# a head whose reductions are short or empty, followed by one whose
+# reductions have every length up to the full dimension: the segments
+# (and locks, if any) of the second head follow those of the first
+def mixed_layout(H, rows, cols):
+  layout = torch.zeros((H, rows, cols), dtype=torch.int64)
+  for i in range(0, min(rows, cols), 2):
+    layout[0, i, i] = 1
+  layout[1:, :, :] = torch.tril(torch.ones((rows, cols), dtype=torch.int64))
+  return layout
+
+@pytest.mark.parametrize("MODE, TRANS_A, TRANS_B",
+    [
+    (mode, at, bt) for mode in ['dsd', 'dds']\
+                   for at   in [False, True]\
+                   for bt   in [False, True]
+    ]
+)
+def test_mixed_heads(MODE, TRANS_A, TRANS_B, BLOCK = 32):
+  test_op(MODE, TRANS_A, TRANS_B, BLOCK, make_layout = mixed_layout)
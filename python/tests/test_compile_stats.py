@@ -0,0 +1,56 @@
+import json
+import torch
+import triton
+
+src = """
+__global__ void add(float* X __noalias __readonly __aligned(16),
+                    float* Y __noalias __readonly __aligned(16),
+                    float* Z __noalias __aligned(16),
+                    int N) {
+    int pid = get_program_id(0);
+    int off[BLOCK] = pid * BLOCK + 0 ... BLOCK;
+    bool check[BLOCK] = off < N;
+    float* px[BLOCK] = X + off;
+    float* py[BLOCK] = Y + off;
+    float* pz[BLOCK] = Z + off;
+    float z[BLOCK] = *?(check)px + *?(check)py;
+    *?(check)pz = z;
+}
+"""
+
+def test_compile_stats(tmp_path, monkeypatch):
+    # kernels loaded from the cache were not compiled and have no statistics
+    monkeypatch.setenv('TRITON_CACHE_DIR', str(tmp_path / 'cache'))
+    # labels of configurations hold the defines, quotes and backslashes included
+    defines = {'BLOCK': [128, 256], 'NAME': ['"a\\\\b"']}
+    kernel = triton.kernel(src, device = torch.device('cpu'), defines = defines)
+    path = tmp_path / 'stats.json'
+    # one list of passes per configuration
+    kernel.dump_compile_stats(str(path))
+    stats = json.loads(path.read_text())
+    assert len(stats) == 2
+    for label, passes in stats.items():
+        assert 'NAME="a\\\\b"' in label
+        names = [p['name'] for p in passes]
+        for name in ['dce', 'align', 'generator', 'llvm-codegen']:
+            assert name in names
+        for p in passes:
+            assert isinstance(p['num_insts_before'], int)
+            assert isinstance(p['num_insts_after'], int)
+            assert p['time_us'] >= 0
+        assert passes[0]['num_insts_before'] > 0
+        for p in passes:
+            if p['name'] == 'dce':
+                assert p['num_insts_after'] <= p['num_insts_before']
+    # one row per configuration, and one span per pass
+    kernel.dump_compile_stats(str(path), format = 'chrome')
+    events = json.loads(path.read_text())['traceEvents']
+    rows = [e['args']['name'] for e in events if e['ph'] == 'M']
+    assert sorted(rows) == sorted(stats.keys())
+    spans = [e for e in events if e['ph'] == 'X']
+    assert len(spans) == sum(len(p) for p in stats.values())
+    for e in spans:
+        label = rows[e['tid']]
+        assert e['name'] in [p['name'] for p in stats[label]]
+        assert isinstance(e['args']['num_insts_before'], int)
+        assert isinstance(e['args']['num_insts_after'], int)
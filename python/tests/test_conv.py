@@ -1,12 +1,17 @@
+import pytest
 import torch
 import triton
 
-
-def test_op():
+# shapes run in sequence share one compiled kernel
+@pytest.mark.parametrize("N, H, W, CI, CO, R, S, pad, stride", [
+    (1, 56, 56, 1024, 1024, 3, 3, (1, 1), (1, 1)),
+    (2, 28, 28, 256, 512, 3, 3, (1, 1), (2, 2)),
+    (1, 17, 23, 64, 128, 1, 1, (0, 0), (1, 1)),
+    (1, 15, 15, 64, 64, 5, 5, (2, 2), (1, 1)),
+])
+def test_op(N, H, W, CI, CO, R, S, pad, stride):
     torch.manual_seed(0)
     DTYPE = torch.float16
-    N, H, W, CI, CO, R, S = 1, 56, 56, 1024, 1024, 3, 3
-    pad, stride, = (1, 1), (1, 1)
     dilation = (1, 1)
     a = torch.rand((N , CI, H, W ), dtype=DTYPE, device='cuda')  / CI**.5
     b = torch.rand((CI, R , S, CO), dtype=DTYPE, device='cuda')  / CI**.5
@@ -14,4 +19,4 @@ def test_op():
     tt_c = triton.ops.conv(a, b, pad, stride)
     rtol, atol = {torch.float32: (1e-4, 1e-5),
                   torch.float16: (1e-2, 1e-3)}[DTYPE]
-    assert torch.allclose(tt_c, th_c, atol=atol, rtol=rtol)
\ No newline at end of file
+    assert torch.allclose(tt_c, th_c, atol=atol, rtol=rtol)
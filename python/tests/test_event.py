@@ -0,0 +1,115 @@
+import torch
+import triton
+
+src = """
+__global__ void add(float* X __noalias __readonly __aligned(16),
+                    float* Y __noalias __readonly __aligned(16),
+                    float* Z __noalias __aligned(16),
+                    int N) {
+    int pid = get_program_id(0);
+    int off[BLOCK] = pid * BLOCK + 0 ... BLOCK;
+    bool check[BLOCK] = off < N;
+    float* px[BLOCK] = X + off;
+    float* py[BLOCK] = Y + off;
+    float* pz[BLOCK] = Z + off;
+    float z[BLOCK] = *?(check)px + *?(check)py;
+    *?(check)pz = z;
+}
+"""
+
+# large enough for launches to still run when the next call is made
+N = 1 << 22
+cpu = torch.device('cpu')
+kernels = dict()
+def get_kernel():
+    if 'add' not in kernels:
+        kernels['add'] = triton.kernel(src, device = cpu, defines = {'BLOCK': [1024]})
+    return kernels['add']
+
+def add(x, y, z):
+    get_kernel()(x, y, z, z.numel(), grid = ('cdiv(N, BLOCK)', ))
+
+def test_record():
+    x = torch.rand(N)
+    y = torch.empty(N)
+    start, end = triton.event(), triton.event()
+    add(x, x, y)
+    start.record()
+    add(y, x, y)
+    end.record()
+    end.synchronize()
+    assert end.query() and start.query()
+    assert torch.allclose(y, 3*x)
+    assert end.elapsed_time(start) >= 0
+
+# an event that was never recorded is complete
+def test_not_recorded():
+    e = triton.event()
+    s = triton.stream()
+    assert e.query()
+    s.wait(e)
+    s.synchronize()
+
+def test_streams():
+    # streams can be swapped once the default stream of the host exists
+    get_kernel()
+    a, b = triton.stream(), triton.stream()
+    e = triton.event()
+    for i in range(10):
+        x = torch.rand(N)
+        y = torch.empty(N)
+        z = torch.empty(N)
+        with a:
+            add(x, x, y)
+            add(y, y, y)
+            e.record()
+        b.wait(e)
+        with b:
+            add(y, x, z)
+        b.synchronize()
+        assert torch.allclose(z, 5*x)
+        a.synchronize()
+    # blocks nest
+    with a:
+        with b:
+            add(x, x, y)
+            e.record(b)
+        e.synchronize()
+        assert torch.allclose(y, 2*x)
+
+# records on different streams complete out of order; streams wait
+# for the record that was last when `wait` was called
+def test_record_order():
+    get_kernel()
+    a, b, c = triton.stream(), triton.stream(), triton.stream()
+    x = torch.rand(N)
+    y = torch.empty(N)
+    z = torch.empty(N)
+    e = triton.event()
+    with a:
+        add(x, x, y)
+        add(y, y, y)
+    e.record(a)
+    c.wait(e)
+    e.record(b)
+    with c:
+        add(y, x, z)
+    c.synchronize()
+    assert torch.allclose(z, 5*x)
+    a.synchronize()
+
+# events complete right away behind a launch; a long run of them
+# must not exhaust the stack of the thread that starts them
+def test_many_records():
+    x = torch.rand(N)
+    y = torch.empty(N)
+    get_kernel()
+    s = triton.stream()
+    e = triton.event()
+    with s:
+        add(x, x, y)
+        for i in range(100000):
+            e.record()
+    s.synchronize()
+    assert e.query()
+    assert torch.allclose(y, 2*x)
@@ -0,0 +1,124 @@
+import torch
+import triton
+
+src = """
+__global__ void add(float* X __noalias __readonly __aligned(16),
+                    float* Y __noalias __readonly __aligned(16),
+                    float* Z __noalias __aligned(16),
+                    int N) {
+    int pid = get_program_id(0);
+    int off[BLOCK] = pid * BLOCK + 0 ... BLOCK;
+    bool check[BLOCK] = off < N;
+    float* px[BLOCK] = X + off;
+    float* py[BLOCK] = Y + off;
+    float* pz[BLOCK] = Z + off;
+    float z[BLOCK] = *?(check)px + *?(check)py;
+    *?(check)pz = z;
+}
+"""
+
+N = 4096
+cpu = torch.device('cpu')
+kernels = dict()
+def get_kernel():
+    if 'add' not in kernels:
+        # a single configuration, so that launches are not auto-tuned during capture
+        kernels['add'] = triton.kernel(src, device = cpu, defines = {'BLOCK': [128]})
+    return kernels['add']
+
+def add(x, y, z):
+    get_kernel()(x, y, z, z.numel(), grid = ('cdiv(N, BLOCK)', ))
+
+def capture(fn, allocations):
+    # graphs capture the stream of the host, created with the first kernel
+    get_kernel()
+    graph = triton.graph()
+    graph.begin_capture()
+    fn()
+    graph.end_capture()
+    for x in allocations:
+        graph.add_allocation(x)
+    return graph
+
+def replay(graph):
+    graph.replay()
+    triton.synchronize(cpu)
+
+# dependent launches run in capture order, and only on replay
+def test_replay_order():
+    x = torch.ones(N)
+    y = torch.zeros(N)
+    z = torch.zeros(N)
+    def fn():
+        add(x, x, y)
+        add(y, x, z)
+        add(z, y, z)
+    graph = capture(fn, [x, y, z])
+    assert graph.num_launches() == 3
+    assert graph.successors(0) == [1]
+    assert graph.successors(1) == [2]
+    assert torch.all(z == 0)
+    replay(graph)
+    assert torch.all(y == 2) and torch.all(z == 5)
+    x.fill_(2)
+    replay(graph)
+    assert torch.all(y == 4) and torch.all(z == 10)
+
+# launches on different allocations are independent
+def test_independent():
+    x, y = torch.ones(N), torch.zeros(N)
+    a, b = torch.ones(N), torch.zeros(N)
+    def fn():
+        add(x, x, y)
+        add(a, a, b)
+        add(y, b, y)
+    graph = capture(fn, [x, y, a, b])
+    assert graph.successors(0) == [2]
+    assert graph.successors(1) == [2]
+    replay(graph)
+    assert torch.all(y == 4)
+
+def test_rebind():
+    x = torch.ones(N)
+    w = torch.full((N, ), 3.)
+    y = torch.zeros(N)
+    graph = capture(lambda: add(x, x, y), [x, w, y])
+    graph.rebind(x, w)
+    replay(graph)
+    assert torch.all(y == 6)
+    graph.rebind(w.data_ptr(), x.data_ptr())
+    replay(graph)
+    assert torch.all(y == 2)
+
+# views into one declared allocation are ordered, even with different pointers
+def test_overlapping():
+    x = torch.ones(2*N)
+    y = torch.zeros(2*N)
+    z = torch.zeros(N)
+    def fn():
+        add(x, x, y)
+        add(y[N:], y[N:], z)
+    graph = capture(fn, [x, y, z])
+    assert graph.successors(0) == [1]
+    replay(graph)
+    assert torch.all(z == 4)
+
+# launches whose pointers are not declared are ordered with every launch
+def test_undeclared():
+    x, y = torch.ones(N), torch.zeros(N)
+    a, b = torch.ones(N), torch.zeros(N)
+    u = torch.zeros(N)
+    def fn():
+        add(x, x, y)
+        add(a, a, b)
+        add(y, y, u)
+        add(x, x, b)
+    graph = capture(fn, [x, y, a, b])
+    assert graph.successors(0) == [2]
+    assert graph.successors(1) == [2]
+    assert graph.successors(2) == [3]
+    replay(graph)
+    assert torch.all(u == 4) and torch.all(b == 2)
+    # nothing declared: the launches form a chain
+    graph = capture(fn, [])
+    assert [graph.successors(i) for i in range(3)] == [[1], [2], [3]]
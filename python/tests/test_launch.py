@@ -0,0 +1,69 @@
+import pytest
+import torch
+import triton
+
+src = """
+__global__ void add(float* X __noalias __readonly __aligned(16),
+                    float* Y __noalias __readonly __aligned(16),
+                    float* Z __noalias __aligned(16),
+                    int N) {
+    int pid = get_program_id(0);
+    int off[BLOCK] = pid * BLOCK + 0 ... BLOCK;
+    bool check[BLOCK] = off < N;
+    float* px[BLOCK] = X + off;
+    float* py[BLOCK] = Y + off;
+    float* pz[BLOCK] = Z + off;
+    float z[BLOCK] = *?(check)px + *?(check)py;
+    *?(check)pz = z;
+}
+"""
+
+kernels = dict()
+def get_kernel(device):
+    if device not in kernels:
+        kernels[device] = triton.kernel(src, device = device, defines = {'BLOCK': [128, 256]})
+    return kernels[device]
+
+# grids given as expressions are evaluated natively, against integer
+# arguments and the defines of the configuration
+@pytest.mark.parametrize("N", [1, 1000, 4096])
+@pytest.mark.parametrize("as_ptr", [False, True])
+def test_op(N, as_ptr):
+    x = torch.randn(N, device='cuda')
+    y = torch.randn(N, device='cuda')
+    z = torch.empty_like(x)
+    kernel = get_kernel(x.device)
+    args = (x.data_ptr(), y.data_ptr(), z.data_ptr()) if as_ptr else (x, y, z)
+    kernel(*args, N, grid = ('cdiv(N, BLOCK)', ))
+    assert torch.allclose(z, x + y)
+
+def test_errors():
+    x = torch.randn(64, device='cuda')
+    kernel = get_kernel(x.device)
+    # arity
+    with pytest.raises(TypeError):
+        kernel(x, x, x, grid = ('cdiv(N, BLOCK)', ))
+    # type of pointers and of scalars
+    with pytest.raises(TypeError):
+        kernel(x, x, 1.5, 64, grid = ('cdiv(N, BLOCK)', ))
+    with pytest.raises(TypeError):
+        kernel(x, x, x, 'a', grid = ('cdiv(N, BLOCK)', ))
+    # grid expressions
+    with pytest.raises(RuntimeError):
+        kernel(x, x, x, 0, grid = ('cdiv(BLOCK, N)', ))
+    with pytest.raises(RuntimeError):
+        kernel(x, x, x, 64, grid = ('cdiv(N, M)', ))
+    # a rejected grid does not break later ones
+    z = torch.empty_like(x)
+    kernel(x, x, z, 64, grid = ('(N + BLOCK - 1) / BLOCK', ))
+    assert torch.allclose(z, x + x)
+
+# grids made of literals are compiled again once too many were kept
+def test_many_grids():
+    x = torch.randn(256*triton.kernel.max_grids, device='cuda')
+    kernel = get_kernel(x.device)
+    for n in range(1, 2*triton.kernel.max_grids):
+        z = torch.zeros_like(x)
+        kernel(x, x, z, 128*n, grid = (str(n), ))
+        assert torch.allclose(z[:128*n], (x + x)[:128*n])
+        assert len(kernel.grids) <= triton.kernel.max_grids
@@ -65,6 +65,32 @@ def test_op(TM, TN, TK, NWARP, M, N, K, AT, BT, DTYPE):
     assert th.allclose(tt_c, th_c, atol=atol, rtol=rtol)
 
 
+# dots on the host never use the layout of tensor cores, whatever their type
+@pytest.mark.parametrize("TM, TN, TK, M, N, K, DTYPE", [
+    (16, 16, 16, 16, 16, 16, 'float16'),
+    (32, 64, 16, 107, 233, 256, 'float16'),
+    (32, 64, 16, 107, 233, 256, 'float32'),
+    # operands too large to be spilled on the stack of the workers
+    (128, 128, 32, 256, 256, 64, 'float16'),
+    (128, 128, 32, 256, 256, 64, 'float32'),
+])
+def test_op_host(TM, TN, TK, M, N, K, DTYPE):
+    DTYPE = {'float16': th.float16, 'float32': th.float32}[DTYPE]
+    th.manual_seed(0)
+    tt.ops._matmul._kernels = dict()
+    tt.ops._matmul.TM = [TM]
+    tt.ops._matmul.TN = [TN]
+    tt.ops._matmul.TK = [TK]
+    tt.ops._matmul.num_warps = [1]
+    a = th.randn((M, K), dtype=DTYPE) / K**.5
+    b = th.randn((K, N), dtype=DTYPE) / K**.5
+    th_c = th.matmul(a.float(), b.float()).to(DTYPE)
+    tt_c = tt.ops.matmul(a, b)
+    rtol, atol = {th.float32: (1e-4, 1e-5),
+                  th.float16: (1e-2, 1e-3)}[DTYPE]
+    assert th.allclose(tt_c, th_c, atol=atol, rtol=rtol)
+
+
 def do_bench(fn, flops = 0, warmup = 10, rep = 50):
     start_event = th.cuda.Event(enable_timing=True)
     end_event   = th.cuda.Event(enable_timing=True)
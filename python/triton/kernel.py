@@ -47,11 +47,15 @@ def read(path):
 
 class kernel:
 
-  def __init__(self, src, device, defines = dict(), num_warps = [4]):
+  # grids given as expressions that are kept compiled, per kernel
+  max_grids = 64
+
+  def __init__(self, src, device, defines = dict(), num_warps = [4], autotune_bucket = 'pow2'):
     self.src = src
     self.opt = libtriton.options_space()
     self.opt.defines = [(k, th_to_triton(v)) for k, v in defines.items()]
     self.opt.num_warps = num_warps
+    self.opt.bucket = getattr(libtriton.autotune_bucket, autotune_bucket)
     # device
     assert device.type in ['cuda', 'cpu']
     if device.type == 'cuda':
@@ -66,7 +70,25 @@ class kernel:
     # signature
     arg_types = libtriton.get_fn_signature(self.op_id)
     self.tys = ''.join([codes[x] for x in arg_types])
+    # ids of the grids given as expressions
+    self.grids = dict()
+
+  # time spent in each compilation step, per configuration
+  def compile_stats(self):
+    return dict(libtriton.get_compile_stats(self.op_id))
+
+  # format: 'json', or 'chrome' for chrome://tracing
+  def dump_compile_stats(self, path, format = 'json'):
+    assert format in ['json', 'chrome']
+    if format == 'json':
+      data = libtriton.get_compile_stats_json(self.op_id)
+    else:
+      data = libtriton.get_compile_trace(self.op_id)
+    with open(path, 'w') as f:
+      f.write(data)
 
+  # `grid` is either a function of the options, or a tuple of expressions
+  # such as ('cdiv(M, TM)', 'cdiv(N, TN)') that are evaluated natively
   def __call__(self, *args, grid):
     # debug mode (initialize)
     if self.is_debug:
@@ -76,6 +98,28 @@ class kernel:
         if isinstance(args[i], torch.Tensor):
           args[i] = libtriton.cuda_empty_like(args[i])
           args[i].copy_(_args[i])
+    if callable(grid):
+      self._launch_packed(args, grid)
+    else:
+      # arguments are written directly into a native buffer
+      key = tuple(grid)
+      grid_id = self.grids.get(key)
+      if grid_id is None:
+        # e.g. grids made of changing literals: start over
+        if len(self.grids) >= kernel.max_grids:
+          libtriton.clear_grid_exprs(self.op_id)
+          self.grids.clear()
+        grid_id = libtriton.register_grid_expr(self.op_id, [str(x) for x in key])
+        self.grids[key] = grid_id
+      libtriton.launch(self.op_id, self.device, grid_id, *args)
+    # debug mode (finalize)
+    if self.is_debug:
+      for i in range(len(args)):
+        if isinstance(args[i], torch.Tensor):
+          _args[i].copy_(args[i].clone())
+      args = _args
+
+  def _launch_packed(self, args, grid):
     # initialize cuda device if necessary
     libtriton.cuda_set_device(self.device)
     # pack parameters into a byte buffer
@@ -88,9 +132,84 @@ class kernel:
     grid_1 = 1 if len(grid) < 2 else grid[1]
     grid_2 = 1 if len(grid) < 3 else grid[2]
     libtriton.launch_kernel(self.op_id, self.device, params, grid_0, grid_1, grid_2)
-    # debug mode (finalize)
-    if self.is_debug:
-      for i in range(len(args)):
-        if isinstance(args[i], torch.Tensor):
-          _args[i].copy_(args[i].clone())
-      args = _args
\ No newline at end of file
+
+
+# streams of the host. launches go to the stream of the innermost
+# `with` block, or to the default stream of the host outside of them
+class stream:
+
+  def __init__(self):
+    self.s = libtriton.host_stream()
+    self.prev = []
+
+  # work submitted from now on starts once the last record of `event` completed
+  def wait(self, event):
+    self.s.wait(event.e)
+
+  def synchronize(self):
+    self.s.synchronize()
+
+  def __enter__(self):
+    self.prev.append(libtriton.set_host_stream(self.s))
+    return self
+
+  def __exit__(self, *args):
+    libtriton.set_host_stream(self.prev.pop())
+
+# events of the host
+class event:
+
+  def __init__(self):
+    self.e = libtriton.host_event()
+
+  # completes once the work submitted to `stream` so far is done;
+  # `stream` defaults to the stream that launches currently go to
+  def record(self, stream = None):
+    self.e.record(libtriton.get_host_stream() if stream is None else stream.s)
+
+  # whether the last record completed
+  def query(self):
+    return self.e.query()
+
+  def synchronize(self):
+    self.e.synchronize()
+
+  # milliseconds between the completions of the last records of `start` and of this event
+  def elapsed_time(self, start):
+    return self.e.elapsed_time(start.e)
+
+def _address(x):
+  return x.data_ptr() if isinstance(x, torch.Tensor) else x
+
+# launches on the host between `begin_capture` and `end_capture` are recorded
+# instead of run; `replay` runs them again, asynchronously, in capture order
+# for launches that share an allocation and concurrently otherwise
+class graph:
+
+  def __init__(self):
+    self.g = libtriton.host_graph()
+
+  def begin_capture(self):
+    self.g.begin_capture()
+
+  def end_capture(self):
+    self.g.end_capture()
+
+  def replay(self):
+    self.g.replay()
+
+  # launches with a pointer outside of every declared allocation
+  # are ordered with all other launches
+  def add_allocation(self, x):
+    storage = x.storage()
+    self.g.add_allocation(storage.data_ptr(), storage.size()*storage.element_size())
+
+  # `old` and `new` are tensors or addresses
+  def rebind(self, old, new):
+    self.g.rebind(_address(old), _address(new))
+
+  def num_launches(self):
+    return self.g.num_launches()
+
+  def successors(self, i):
+    return self.g.successors(i)
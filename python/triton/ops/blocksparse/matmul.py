@@ -16,58 +16,6 @@ class _matmul(torch.autograd.Function):
   dds_cache = dict()
   locks = dict()
 
-  # Given an array sizes representing reduction size for each
-  # column of a block-mode matrix multiplication,
-  # performs load-balancing to achieve more smaller reductions
-  # between `seg_size` elements
-  @staticmethod
-  def load_balance(sizes, block):
-    # segment size
-    # heuristics taken from OpenAI blocksparse code
-    # https://github.com/openai/blocksparse/blob/master/blocksparse/matmul.py#L95
-    max_size = sizes.max()
-    min_size = sizes[sizes != 0].min()
-    #if max_size > min_size * 2.0:
-    #  seg_max = max(triton.cdiv(max_size, 4), min_size*2)
-    #else:
-    #  seg_max = max_size
-    seg_max = max_size
-    seg_min = max(triton.cdiv(seg_max, 4), 4)
-    # split reduction into segments
-    div = sizes // seg_max
-    rem = sizes % seg_max
-    packs = div + (sizes < seg_min).long() + (rem >= seg_min).long()
-    width = packs.sum()
-    segments = torch.empty(width, dtype=sizes.dtype)
-    column = torch.empty_like(segments)
-    lockid = torch.zeros_like(segments)
-    maxid = torch.zeros_like(segments)
-    nlocks = 0
-    current = 0
-    col_idx = 0
-    for i in range(len(sizes)):
-      d, r = div[i], rem[i]
-      isempty = sizes[i] < seg_min
-      last = current + d + (r >= seg_min) + isempty
-      # column id
-      column[current:last] = col_idx
-      # lock id
-      if d > 1 or (d == 1 and r >= seg_min):
-        nlocks += 1
-        lockid[current:last] = nlocks
-        maxid[current:last] = last - current
-      # segment size
-      segments[current:current+d] = seg_max
-      if r < seg_min and not isempty:
-        segments[current+d-1] += r
-      if r >= seg_min or isempty:
-        segments[current+d] = r
-      current = last
-      col_idx += 1
-    offsets = torch.zeros_like(segments)
-    offsets[1:] = torch.cumsum(segments[:-1], dim=0)
-    return segments, column, lockid, maxid, offsets
-  
   @staticmethod
   def get_locks(size, dev):
     if dev not in _matmul.locks or \
@@ -81,20 +29,11 @@ class _matmul(torch.autograd.Function):
 
   @staticmethod
   def make_sdd_lut(layout, block, dtype, device):
-    start_width = 64 // block
-    superblocks = libtriton.superblock(layout.type(torch.int32), start_width)
-    luts, widths, packs = [], [], []
-    for size, nnz in superblocks:
-      width = nnz.shape[0] // (size*size)
-      h = nnz[:, 0]
-      i = nnz[:, 1]
-      j = nnz[:, 2]
-      b = nnz[:, 3]
-      lut = torch.stack((h, i, j, b), dim=1).view(-1).contiguous()
-      luts.append(lut.type(torch.int32).to(device)) 
-      widths.append(width)
-      packs.append(size)
-    # create locks
+    # built natively, and shared by layers that use the same layout
+    superblocks = libtriton.make_sdd_lut(layout, block, device)
+    luts   = [lut for lut, width, pack in superblocks]
+    widths = [width for lut, width, pack in superblocks]
+    packs  = [pack for lut, width, pack in superblocks]
     return luts, None, widths, packs
 
   @staticmethod
@@ -168,91 +107,8 @@ class _matmul(torch.autograd.Function):
   # Given a binary layout of 0s and 1s,
   # Construct look-up table for efficient execution on GPUs
   @staticmethod
-  def make_dxx_lut(layout, block, step, trans, device, transform = lambda idx: idx):
-    # load-balancing
-    _empty = torch.tensor([], dtype=torch.int64, device=layout.device)
-    segments = _empty.clone()
-    column   = _empty.clone()
-    depth    = _empty.clone()
-    lockid   = _empty.clone()
-    maxid    = _empty.clone()
-    offsets  = _empty.clone()
-    current_offset = 0
-    current_maxid = 0
-    for z in range(layout.size(0)):
-      if trans:
-        sizes = torch.sum(layout[z, :, :], 1)
-      else:
-        sizes = torch.sum(layout[z, :, :], 0)
-      z_segments, z_column, z_lockid, z_maxid, z_offsets = _matmul.load_balance(sizes, block)
-      z_depth = z * torch.ones_like(z_segments)
-      z_lockid[z_lockid > 0] += current_maxid
-      current_maxid = z_lockid.max()
-      # concatenate depth
-      segments = torch.cat((segments, z_segments))
-      column   = torch.cat((column,    z_column))
-      depth    = torch.cat((depth,     z_depth))
-      maxid    = torch.cat((maxid,     z_maxid))
-      offsets  = torch.cat((offsets,   current_offset + z_offsets))
-      lockid   = torch.cat((lockid,    z_lockid))
-      current_offset += layout[z, :, :].sum()
-    segments *= step
-    # pointer increments
-    if trans:
-      nnz = layout.nonzero(as_tuple=False)
-    else:
-      nnz = layout.transpose(1, 2).nonzero(as_tuple=False)
-    num_blocks = nnz.size(0)
-    offsets = torch.min(offsets, (num_blocks - 1)*torch.ones_like(offsets))
-    idx = transform(nnz[:, 2]*block)
-    xincs = idx.clone() 
-    xincs[1:] -= idx[:-1]
-    # divide block into multiple steps
-    div = block // step
-    xincs = xincs.view(-1, 1).repeat(1, div)
-    xincs[:, 1:] = step
-    xincs[:, 0 ] -= (div-1)*step
-    # first increment for each reduction is actually the offset
-    xincs[offsets[segments>0], 0] = idx[offsets[segments>0]]
-    xincs = xincs.view(-1)
-    # block-mode input increments
-    if trans:
-      widx = torch.arange(num_blocks)
-    else:
-      widx = _empty.clone()
-      current_offset = 0
-      for z in range(layout.size(0)):
-        layoutw = layout[z, :, :].clone()
-        msum = layoutw.sum()
-        layoutw[layoutw > 0] = 1 + torch.arange(msum)
-        widx = torch.cat((widx, current_offset + layoutw.T[layoutw.T > 0] - 1))
-        current_offset += msum
-    widx = widx
-    wincs = widx*block*block
-    wincs[1:] -= widx[:-1]*block*block
-    wincs = wincs.view(-1, 1).repeat(1, div)
-    if trans:
-      wincs[:, 1:] = step
-      wincs[:, 0] -= (div-1)*step
-    else:
-      wincs[:, 1:] = step*block
-      wincs[:, 0] -= (div - 1)*step*block
-    wincs[offsets[segments>0], 0] = widx[offsets[segments>0]]
-    wincs = wincs.view(-1)
-    # adjust offset and segment size
-    offsets *= 2*div
-    segments *= div
-    # create header
-    width = column.size(0)
-    offsets += 6*width
-    header = torch.stack((offsets, segments, column, depth, lockid, maxid), dim=1).view(-1).contiguous()
-    incs = torch.stack((xincs, wincs), dim=1).view(-1).contiguous()
-    incs = torch.cat((incs, torch.zeros(2, device=incs.device, dtype=incs.dtype)))
-    # create lut
-    lut = torch.cat((header, incs))
-    lut = lut.type(torch.int32).to(device)
-    # create locks
-    num_locks = max(1, lockid.max())
+  def make_dxx_lut(layout, block, step, trans, device):
+    lut, num_locks, width = libtriton.make_dxx_lut(layout, block, step, trans, device)
     return lut, num_locks, width, None
 
   @staticmethod
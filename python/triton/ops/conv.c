@@ -5,19 +5,21 @@ __global__ void conv(TYPE *A __noalias __readonly __aligned(16),
                          // equivalent matmul
                          int M, int N,  int K,
                          // convolution properties
+                         int H, int W, int R, int S, int P, int Q,
                          int pad_h, int pad_w, int stride_h, int stride_w,
                          // pointer increment
                          int *ADELTA,
                          // memory strides
-                         int lda_z  __multipleof(8), int lda_ci __multipleof(8), int lda_h __multipleof(8), int lda_w __multipleof(8),
+                         // (those of A and C depend on the image size)
+                         int lda_z, int lda_ci, int lda_h, int lda_w,
                          int ldb_ci __multipleof(8), int ldb_r  __multipleof(8), int ldb_s __multipleof(8), int ldb_co __multipleof(8),
-                         int ldc_z  __multipleof(8), int ldc_co __multipleof(8), int ldc_p __multipleof(8), int ldc_q __multipleof(8)) {
+                         int ldc_z, int ldc_co, int ldc_p, int ldc_q) {
       // prologue
       int ridx = get_program_id(0);
       int ridy = get_program_id(1);
       int ridz = get_program_id(2);
-      int gridx = M / TM;
-      int gridy = N / TN;
+      int gridx = (M + TM - 1) / TM;
+      int gridy = (N + TN - 1) / TN;
       int rid = ridx + ridy * gridx;
       ridx = rid / gridy;
       ridy = rid % gridy;
@@ -29,16 +31,16 @@ __global__ void conv(TYPE *A __noalias __readonly __aligned(16),
 
       // unpack aggregate rows
       // m = (z, p, q)
-      int rq[TM]   = rm  % QQ;
-      int rzp[TM]  = rm  / QQ;
-      int rp[TM]   = rzp % PP;
-      int rz[TM]   = rzp / PP;
+      int rq[TM]   = rm  % Q;
+      int rzp[TM]  = rm  / Q;
+      int rp[TM]   = rzp % P;
+      int rz[TM]   = rzp / P;
       // unpack aggregate reduction
       // k = (ci, r, s)
-      int rs  [TK] = rk % SS;
-      int rcir[TK] = rk / SS;
-      int rr  [TK] = rcir % RR;
-      int rci [TK] = rcir / RR;
+      int rs  [TK] = rk % S;
+      int rcir[TK] = rk / S;
+      int rr  [TK] = rcir % R;
+      int rci [TK] = rcir / R;
 
       // padding / striding
       int rh_0[TM] = rp * stride_h - pad_h;
@@ -62,7 +64,7 @@ __global__ void conv(TYPE *A __noalias __readonly __aligned(16),
 
       // prefetches operands
       bool checkam[TM, TK] = rm[:, newaxis] < M;
-      bool checka[TM, TK] = checkam && rh >= 0 && rh < HH && rw >= 0 && rw < WW;
+      bool checka[TM, TK] = checkam && rk[newaxis, :] < K && rh >= 0 && rh < H && rw >= 0 && rw < W;
       bool checkb[TK, TN] = rk[:, newaxis] < K;
       TYPE a[TM, TK] = checka ? *pa : 0;
       TYPE b[TK, TN] = checkb ? *pb : 0;
@@ -78,12 +80,12 @@ __global__ void conv(TYPE *A __noalias __readonly __aligned(16),
         pa += adelta[newaxis, :];
         // bounds-checking A
         rk += TK;
-        rs = rk % SS;
-        rcir = rk / SS;
-        rr = rcir % RR;
+        rs = rk % S;
+        rcir = rk / S;
+        rr = rcir % R;
         rh = rh_0[:, newaxis] + rr[newaxis, :];
         rw = rw_0[:, newaxis] + rs[newaxis, :];
-        bool checka[TM, TK] = checkam && rh >= 0 && rh < HH && rw >= 0 && rw < WW;
+        bool checka[TM, TK] = checkam && rk[newaxis, :] < K && rh >= 0 && rh < H && rw >= 0 && rw < W;
         // increment B
         pb += TK * ldb_s;
         // bounds-checking B
@@ -97,10 +99,10 @@ __global__ void conv(TYPE *A __noalias __readonly __aligned(16),
       // epilogue
       rm  = ridx * TM + 0 ... TM;
       rn  = ridy * TN + 0 ... TN;
-      rq  = rm  % QQ;
-      rzp = rm  / QQ;
-      rp  = rzp % PP;
-      rz  = rzp / PP;
+      rq  = rm  % Q;
+      rzp = rm  / Q;
+      rp  = rzp % P;
+      rz  = rzp / P;
       int offc[TM, TN] = rz [:, newaxis] * ldc_z +
                          rn [newaxis, :] * ldc_co+
                          rp [:, newaxis] * ldc_p +
@@ -1,18 +1,12 @@
 import torch
 import triton
+import triton._C.libtriton as libtriton
 import os
 
 class _conv(torch.autograd.Function):
     src = triton.read(os.path.join(os.path.dirname(__file__), 'conv.c'))
     kernel = dict()
-
-    @staticmethod
-    def unpack(IDX, CI, R, S):
-      s  = IDX %  S
-      cr = IDX // S
-      r  = cr  %  R
-      ci = cr  // R
-      return ci, r, s
+    TK = 16
 
     @staticmethod
     def forward(ctx, a, b, pad, stride):
@@ -24,34 +18,31 @@ class _conv(torch.autograd.Function):
       _, R, S, CO = b.shape
       P = (H + 2*pad[0] - R)//stride[0] + 1
       Q = (W + 2*pad[1] - S)//stride[1] + 1
-      # compile kernel
+      # compile kernel; spatial dimensions are arguments,
+      # so one kernel serves every image and filter size
       if (dtype, device) not in _conv.kernel:
-          TK = 16
           defines = {
               'TYPE' : dtype,
               'TM'   : [32, 64, 128],
               'TN'   : [32, 64, 128],
-              'TK'   : [TK],
+              'TK'   : [_conv.TK],
               'TZ'   : [1],
-              'HH': H, 'WW': W, 'PP': P, 'QQ': Q, 'SS': S, 'RR': R,
           }
-          idx = torch.arange(CI*R*S)
-          ci,   r,  s = _conv.unpack(idx, CI, R, S)
-          nci, nr, ns = _conv.unpack(idx + TK, CI, R, S)
-          delta = (nci - ci)*a.stride(1) + (nr - r)*a.stride(2) + (ns - s)*a.stride(3)
-          delta = delta.type(torch.int32).cuda()
-          _conv.kernel[dtype] = (delta, triton.kernel(_conv.src, device=device, num_warps=[4], defines=defines))
-      delta, kernel = _conv.kernel[dtype]
+          _conv.kernel[dtype, device] = triton.kernel(_conv.src, device=device, num_warps=[4], defines=defines)
+      kernel = _conv.kernel[dtype, device]
+      # pointer increments, cached per shape and strides
+      delta = libtriton.conv_delta(CI, R, S, a.stride(1), a.stride(2), a.stride(3), _conv.TK, device)
       # allocate output
       c = torch.empty([Z, CO, P, Q], dtype=dtype, device=device)
       # enqueue
-      kernel(a.data_ptr(), b.data_ptr(), c.data_ptr(), 1., Z*P*Q, CO, CI*R*S, 
+      kernel(a.data_ptr(), b.data_ptr(), c.data_ptr(), 1., Z*P*Q, CO, CI*R*S,
+            H, W, R, S, P, Q,
             pad[0], pad[1], stride[0], stride[1],
             delta.data_ptr(),
             a.stride(0), a.stride(1), a.stride(2), a.stride(3),
             b.stride(0), b.stride(1), b.stride(2), b.stride(3),
             c.stride(0), c.stride(1), c.stride(2), c.stride(3),
-            grid = lambda opt: [triton.cdiv(Z*P*Q, opt.TM), triton.cdiv(CO, opt.TN)])
+            grid = ('cdiv(M, TM)', 'cdiv(N, TN)'))
       return c
 
-conv = _conv.apply
\ No newline at end of file
+conv = _conv.apply
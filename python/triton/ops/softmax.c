@@ -1,8 +1,44 @@
-__global__ void forward(TYPE* X, TYPE* Y) {
+__global__ void forward(TYPE* X __readonly __noalias __aligned(16),
+                        TYPE* Y __noalias __aligned(16),
+                        int N,
+                        int stride_x,
+                        int stride_y) {
     int pid = get_program_id(0);
-    int off[BLOCK] = pid * BLOCK + 0 ... BLOCK;
-    float x[BLOCK] = *(X + off);
+    int rn[BLOCK] = 0 ... BLOCK;
+    TYPE* px[BLOCK] = X + pid * stride_x + rn;
+    TYPE* py[BLOCK] = Y + pid * stride_y + rn;
+#ifdef ONLINE
+    // rows longer than BLOCK: the first pass keeps a running
+    // maximum and rescales the running sum whenever it grows,
+    // the second pass normalizes
+    float m = -F32_INFINITY;
+    float sum = 0;
+    for(int n = 0; n < N; n += BLOCK){
+        bool check[BLOCK] = rn < N - n;
+        float x[BLOCK] = check ? *px : NEG_INF;
+        float x_max = x[max];
+        float m_new = max(m, x_max);
+        float shifted[BLOCK] = exp(x - m_new);
+        sum = sum * exp(m - m_new) + shifted[+];
+        m = m_new;
+        px += BLOCK;
+    }
+    px = X + pid * stride_x + rn;
+    for(int n = 0; n < N; n += BLOCK){
+        bool check[BLOCK] = rn < N - n;
+        float x[BLOCK] = check ? *px : NEG_INF;
+        TYPE y[BLOCK] = exp(x - m) / sum;
+        *?(check)py = y;
+        px += BLOCK;
+        py += BLOCK;
+    }
+#else
+    // the whole row fits in a block
+    bool check[BLOCK] = rn < N;
+    float x[BLOCK] = check ? *px : NEG_INF;
     float shifted[BLOCK] = exp(x - x[max]);
     float sum = shifted[+];
-    *(Y + off) = shifted / sum;
-} 
\ No newline at end of file
+    TYPE y[BLOCK] = shifted / sum;
+    *?(check)py = y;
+#endif
+}
@@ -2,13 +2,26 @@ import torch
 import triton
 import os
 
+# rows of up to MAX_BLOCK elements are loaded at once into a block of the
+# next power of two; longer rows are streamed through blocks of MAX_BLOCK
+MIN_BLOCK = 32
+MAX_BLOCK = 4096
+
+def next_power_of_2(n):
+    return max(MIN_BLOCK, 1 << (n - 1).bit_length())
+
 kernels = dict()
-def get_kernel(block, dtype, device):
-    key = (block, dtype, device)
+def get_kernel(block, online, dtype, device):
+    key = (block, online, dtype, device)
     if key not in kernels:
         src = triton.read(os.path.join(os.path.dirname(__file__), 'softmax.c'))
-        defines = {'BLOCK': block, 'TYPE': dtype}
-        kernels[key] = triton.kernel(src, device = device, defines = defines)
+        # padding of masked loads, in the type of the input
+        neg_inf = '-F16_INFINITY' if dtype == torch.float16 else '-F32_INFINITY'
+        defines = {'BLOCK': block, 'TYPE': dtype, 'NEG_INF': neg_inf}
+        if online:
+            defines['ONLINE'] = 1
+        num_warps = [4] if block <= 1024 else [8]
+        kernels[key] = triton.kernel(src, device = device, defines = defines, num_warps = num_warps)
     return kernels[key]
 
 
@@ -16,12 +29,14 @@ class _softmax(torch.autograd.Function):
 
     @staticmethod
     def forward(ctx, x):
+        if x.stride(-1) != 1:
+            x = x.contiguous()
         y = torch.empty_like(x)
         M, N = x.shape
-        kernel = get_kernel(N, x.dtype, x.device)
-        kernel(x.data_ptr(), y.data_ptr(), grid = lambda opt: [M, ])
+        online = N > MAX_BLOCK
+        block = MAX_BLOCK if online else next_power_of_2(N)
+        kernel = get_kernel(block, online, x.dtype, x.device)
+        kernel(x.data_ptr(), y.data_ptr(), N, x.stride(0), y.stride(0), grid = lambda opt: [M, ])
         return y
 
 softmax = _softmax.apply
-        
-
@@ -1,20 +1,8 @@
-#include "triton/codegen/analysis/axes.h"
-#include "triton/codegen/analysis/allocation.h"
-#include "triton/codegen/analysis/liveness.h"
-#include "triton/codegen/analysis/align.h"
-#include "triton/codegen/analysis/swizzle.h"
+#include "triton/codegen/pipeline.h"
 #include "triton/codegen/target.h"
-#include "triton/codegen/transform/coalesce.h"
-#include "triton/codegen/transform/dce.h"
-#include "triton/codegen/transform/peephole.h"
-#include "triton/codegen/transform/membar.h"
-#include "triton/codegen/transform/reassociate.h"
-#include "triton/codegen/transform/reorder.h"
-#include "triton/codegen/transform/cts.h"
-#include "triton/codegen/transform/disassociate.h"
-#include "triton/codegen/selection/generator.h"
 #include "triton/lang/token.h"
 #include "triton/runtime/function.h"
+#include "triton/runtime/bundle.h"
 #include "triton/lang/cpp.h"
 #include "triton/lang/parser.h"
 #include "triton/lang/code_gen.h"
@@ -28,23 +16,29 @@
 #include "triton/ir/function.h"
 #include "triton/ir/print.h"
 #include "triton/runtime/error.h"
-#include "triton/tools/bench.hpp"
-#include "triton/tools/sha1.hpp"
 #include "triton/tools/sys/getenv.hpp"
-#include "triton/tools/sys/mkdir.hpp"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include <exception>
 #include <fstream>
+#include <functional>
+#include <iostream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 // Usage:
-// triton-cc --num_warps 4 gemm.triton 
-// output:
-// gemm.ll
+// triton-cc --num_warps 4 -D TM=64,128 -D TN=64,128 -o gemm gemm.c
+// output (host target):
+// gemm.0.o ... gemm.3.o  one relocatable object per configuration
+// gemm.bundle.o          description of the bundle, for runtime::function
+// gemm.so                all of the above, unless --emit=obj
+// gemm.h                 entry points, signature and a typed launcher
+// with --target=sm_XX, the LLVM-IR of every configuration is printed instead
 
 using namespace triton;
 using namespace llvm;
@@ -53,161 +47,283 @@ static cl::opt<std::string>
 InputFilename(cl::Positional, cl::desc("<input file>"), cl::init("-"));
 
 static cl::opt<std::string>
-OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"));
-
-static cl::opt<unsigned>
-NumWarps("num_warps", cl::desc("number of warps"), cl::value_desc("num_warps"));
-
-static std::string preheader() {
-  return  R"(
-#define bool _Bool
-#define true 1
-#define false 0
-
-#define __readonly      __attribute__((readonly))
-#define __writeonly     __attribute__((writeonly))
-#define __noalias       __attribute__((noalias))
-#define __aligned(A)    __attribute__((aligned(A)))
-#define __multipleof(A) __attribute__((multipleof(A)))
-#define __retune        __attribute__((retune))
-
-#define F32_INFINITY bitcast<float>(0x7F800000)
-#define F16_INFINITY bitcast<half>((int16)0x7C00)
-
-#define min(a,b) (((a)<(b))?(a):(b))
-#define max(a,b) (((a)>(b))?(a):(b))
-
-#define PASTER(a, b, _) a ## _ ## b
-#define EVALUATOR(a, b, _)  PASTER(a, b, _)
-#define atomic_add(TYPE, TM, TN) EVALUATOR(atomic_add, EVALUATOR(TYPE, EVALUATOR(TM, TN, x), _), _)
-#define DECLARATION(TYPE, TM, TN) extern void atomic_add(TYPE, TM, TN)(TYPE*[TM, TN], TYPE[TM, TN], bool[TM, TN])
-
-DECLARATION(float, 64, 64);
-DECLARATION(float, 64, 128);
-DECLARATION(float, 128, 64);
-DECLARATION(float, 128, 128);
-extern void atomic_add_half_1x1(half*, half, bool);
-
-DECLARATION(half , 64, 64);
-DECLARATION(half , 64, 128);
-DECLARATION(half , 128, 64);
-DECLARATION(half , 128, 128);
-extern void atomic_add_float_1x1(float*, float, bool);
-
-extern int atomic_cas(int*, int, int);
-extern int atomic_xchg(int*, int);
-extern int get_program_id(int);
-extern int get_num_programs(int);
-extern int select(bool, int, int);
-extern char __constant__ * calloc(int);
-
-typedef unsigned char uint8;
-typedef unsigned short uint16;
-typedef unsigned int uint32;
-typedef unsigned long uint64;
-typedef char int8;
-typedef short int16;
-typedef int int32;
-typedef long int64;
-)";
-}
+OutputFilename("o", cl::desc("Output prefix"), cl::value_desc("prefix"));
+
+static cl::list<unsigned>
+NumWarps("num_warps", cl::desc("number of warps"), cl::value_desc("num_warps"), cl::CommaSeparated);
 
+static cl::list<std::string>
+Defines("D", cl::desc("NAME=V0,V1,... (one configuration per value)"), cl::value_desc("define"), cl::Prefix);
 
-static std::unique_ptr<ir::module> parseTritonIRFile(std::string filename) {
+static cl::opt<std::string>
+Target("target", cl::desc("host or sm_XX"), cl::value_desc("target"), cl::init("host"));
+
+static cl::opt<std::string>
+CPU("mcpu", cl::desc("host CPU to compile for (default: this machine)"), cl::value_desc("cpu"));
+
+static cl::opt<std::string>
+Features("mattr", cl::desc("host CPU features, e.g. +avx2,+fma"), cl::value_desc("features"));
+
+static cl::opt<std::string>
+Name("name", cl::desc("name of the bundle (default: name of the kernel)"), cl::value_desc("name"));
+
+static cl::opt<std::string>
+Emit("emit", cl::desc("shared or obj (host target only)"), cl::value_desc("kind"), cl::init("shared"));
+
+
+static std::string readFile(const std::string& filename) {
   std::ifstream f(filename);
   if (!f.is_open()) {
     throw std::runtime_error(filename + " cannot be opened.\n");
   }
   std::stringstream buffer;
   buffer << f.rdbuf();
-  std::string src = buffer.str();
+  return buffer.str();
+}
 
-  ir::context ctx;
+static std::unique_ptr<ir::module> parseTritonIR(std::string src, ir::context& ctx,
+                                                 runtime::options_t opt) {
   std::unique_ptr<ir::module> M = std::make_unique<ir::module>("", ctx);
-
-  src = preheader() + src;
+  src = runtime::kernel::preheader() + src;
   // parse
   TokenSequence tokens;
   Preprocessor cpp(&src, true);
+  for (auto& x: opt.defines)
+    cpp.AddMacro(x.first, &x.second);
   cpp.Process(tokens);
   Parser parser(tokens);
   parser.Parse();
   Generator gen(&parser);
   gen.Gen(M.get());
-
   return M;
 }
 
-static void runPasses(ir::module & M) {
-  std::unique_ptr<codegen::target> target = 
-    std::make_unique<codegen::nvidia_cu_target>(70);
-  
-  LLVMContext ctx;
+// all combinations of num_warps and defines, in the order of runtime::function
+static std::vector<runtime::options_t> enumerateConfigs() {
+  std::vector<std::pair<std::string, std::vector<std::string>>> defines;
+  for (const std::string& D: Defines) {
+    size_t eq = D.find('=');
+    if (eq == std::string::npos)
+      throw std::runtime_error("expected NAME=V0,V1,... but got -D" + D);
+    std::vector<std::string> values;
+    std::istringstream iss(D.substr(eq + 1));
+    std::string value;
+    while (std::getline(iss, value, ','))
+      values.push_back(value);
+    defines.push_back({D.substr(0, eq), values});
+  }
+  std::vector<unsigned> num_warps(NumWarps.begin(), NumWarps.end());
+  if (num_warps.empty())
+    num_warps.push_back(4);
+  std::vector<runtime::options_t> ret(1);
+  ret[0].num_warps = num_warps[0];
+  auto expand = [&](const std::function<void(runtime::options_t&, size_t)>& set, size_t n) {
+    std::vector<runtime::options_t> next;
+    for (const runtime::options_t& opt: ret)
+      for (size_t i = 0; i < n; i++) {
+        next.push_back(opt);
+        set(next.back(), i);
+      }
+    ret = next;
+  };
+  expand([&](runtime::options_t& opt, size_t i) { opt.num_warps = num_warps[i]; }, num_warps.size());
+  for (const auto& D: defines)
+    expand([&](runtime::options_t& opt, size_t i) { opt.defines[D.first] = D.second[i]; }, D.second.size());
+  return ret;
+}
+
+static std::unique_ptr<codegen::target> makeTarget() {
+  if (Target == "host")
+    return driver::host_device().make_target();
+  if (Target.compare(0, 3, "sm_") == 0)
+    return std::make_unique<codegen::nvidia_cu_target>(std::stoi(Target.substr(3)));
+  throw std::runtime_error("unknown target " + Target);
+}
+
+static std::unique_ptr<llvm::Module> runPasses(ir::module & M, codegen::target* target,
+                                               unsigned num_warps, LLVMContext& ctx) {
   std::string name = M.get_function_list()[0]->get_name();
   auto llvm = std::make_unique<llvm::Module>(name, ctx);
 
-  bool cts_use_async = false;
-
-  // create passes
-  printf("create passes\n");
-  codegen::analysis::align align;
-  codegen::analysis::axes axes;
-  codegen::transform::cts cts(cts_use_async);
-  codegen::transform::disassociate disassociate;
-  codegen::analysis::layouts layouts(&axes, &align, NumWarps, target.get());
-  codegen::analysis::liveness liveness(&layouts);
-  codegen::analysis::swizzle swizzle(&layouts, target.get());
-  codegen::analysis::allocation allocation(&liveness);
-  codegen::transform::membar barriers(&liveness, &layouts, &allocation);
-  codegen::transform::dce dce;
-  codegen::transform::peephole peephole(target.get());
-  codegen::transform::reassociate reassociate;
-  codegen::transform::coalesce coalesce(&align, &layouts);
-  codegen::generator isel(&axes, &layouts, &align, &allocation, &swizzle, 
-                          target.get(), NumWarps);
-  printf("run passes\n");
-  dce.run(M);
-  disassociate.run(M);
-  dce.run(M);
-  peephole.run(M);
-  dce.run(M);
-  align.run(M);
-  if(target->is_gpu())
-    cts.run(M);
-  axes.run(M);
-  layouts.run(M);
-  coalesce.run(M);
-  dce.run(M);
-  align.run(M);
-  dce.run(M);
-  if(target->is_gpu()){
-    reassociate.run(M);
-    cts.run(M);
+  // same passes, in the same order, as the runtime
+  codegen::pipeline pipeline(target, num_warps);
+  codegen::pass_manager pm;
+  pm.run(pipeline.schedule(), M);
+  pipeline.insert_barriers(M);
+  pipeline.generate(M, *llvm);
+  return llvm;
+}
+
+static void writeFile(const std::string& filename, const std::string& content) {
+  std::ofstream ofs(filename, std::ios::binary);
+  ofs << content;
+  if (!ofs)
+    throw std::runtime_error("cannot write " + filename);
+}
+
+// C type of a kernel argument in the generated header
+static std::string cType(ir::type* ty) {
+  if (ty->is_pointer_ty())
+    return cType(((ir::pointer_type*)ty)->get_element_ty()) + "*";
+  if (ty->is_integer_ty(1))  return "bool";
+  if (ty->is_integer_ty(8))  return "int8_t";
+  if (ty->is_integer_ty(16)) return "int16_t";
+  if (ty->is_integer_ty(32)) return "int32_t";
+  if (ty->is_integer_ty(64)) return "int64_t";
+  // IEEE half, passed as its bits
+  if (ty->is_half_ty())      return "uint16_t";
+  if (ty->is_float_ty())     return "float";
+  if (ty->is_double_ty())    return "double";
+  throw std::runtime_error("unsupported argument type " + ty->repr());
+}
+
+static std::string header(const runtime::bundle_t& bundle, ir::function* fn) {
+  const std::string& name = bundle.name;
+  std::string fn_ty = "void(char**, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t)";
+  std::vector<std::pair<std::string, std::string>> args;
+  for (size_t i = 0; i < bundle.sig.size(); i++) {
+    std::string arg = fn->args()[i]->get_name();
+    if (arg.empty())
+      arg = "arg" + std::to_string(i);
+    args.push_back({cType(fn->get_fn_type()->get_param_ty(i)), arg});
   }
-  peephole.run(M);
-  dce.run(M);
-  align.run(M);
-  axes.run(M);
-  layouts.run(M);
-  swizzle.run(M);
-  liveness.run(M);
-  allocation.run(M);
-
-  barriers.run(M);
-  isel.visit(M, *llvm);
+  std::ostringstream oss;
+  oss << "// Generated by triton-cc from " << InputFilename << " -- do not edit\n";
+  oss << "#pragma once\n\n";
+  oss << "#include <cstddef>\n#include <cstdint>\n\n";
+  oss << "extern \"C\" {\n";
+  oss << "// description of the bundle, read by triton::runtime::function\n";
+  oss << "extern const char " << runtime::bundle_t::symbol(name) << "[];\n";
+  oss << "// (packed arguments, program ids, grid size)\n";
+  for (const auto& x: bundle.configs)
+    oss << "void " << x.entry << "(char**, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t);\n";
+  oss << "}\n\n";
+  oss << "namespace " << name << " {\n\n";
+  oss << "struct config_t {\n";
+  oss << "  " << fn_ty.substr(0, 4) << "(*fn)" << fn_ty.substr(4) << ";\n";
+  oss << "  unsigned num_warps;\n";
+  oss << "  const char* defines;\n";
+  oss << "};\n\n";
+  oss << "static const config_t configs[] = {\n";
+  for (const auto& x: bundle.configs) {
+    std::map<std::string, std::string> defines(x.opt.defines.begin(), x.opt.defines.end());
+    std::string str;
+    for (const auto& d: defines)
+      str += (str.empty() ? "" : ",") + d.first + "=" + d.second;
+    oss << "  {" << x.entry << ", " << x.opt.num_warps << ", \"" << str << "\"},\n";
+  }
+  oss << "};\n";
+  oss << "static const size_t num_configs = " << bundle.configs.size() << ";\n\n";
+  oss << "// argument types, as triton::runtime::arg_type\n";
+  oss << "static const int signature[] = {";
+  for (size_t i = 0; i < bundle.sig.size(); i++)
+    oss << (i ? ", " : "") << (int)bundle.sig[i];
+  oss << "};\n\n";
+  oss << "// arguments in the layout expected by the entry points\n";
+  oss << "struct args_t {\n";
+  for (const auto& x: args)
+    oss << "  " << x.first << " " << x.second << ";\n";
+  oss << "};\n\n";
+  oss << "// runs every program of the grid on the calling thread\n";
+  oss << "inline void launch(size_t config";
+  for (const auto& x: args)
+    oss << ", " << x.first << " " << x.second;
+  oss << ",\n                   int32_t grid0, int32_t grid1 = 1, int32_t grid2 = 1) {\n";
+  oss << "  args_t args = {";
+  for (size_t i = 0; i < args.size(); i++)
+    oss << (i ? ", " : "") << args[i].second;
+  oss << "};\n";
+  oss << "  for (int32_t k = 0; k < grid2; k++)\n";
+  oss << "  for (int32_t j = 0; j < grid1; j++)\n";
+  oss << "  for (int32_t i = 0; i < grid0; i++)\n";
+  oss << "    configs[config].fn((char**)&args, i, j, k, grid0, grid1, grid2);\n";
+  oss << "}\n\n";
+  oss << "}\n";
+  return oss.str();
+}
+
+// object code of the description of the bundle
+static std::string bundleObject(const runtime::bundle_t& bundle) {
+  LLVMContext ctx;
+  auto M = std::make_unique<llvm::Module>(bundle.name, ctx);
+  llvm::Constant* str = ConstantDataArray::getString(ctx, bundle.to_str());
+  new GlobalVariable(*M, str->getType(), true, GlobalValue::ExternalLinkage,
+                     str, runtime::bundle_t::symbol(bundle.name));
+  return driver::host_module::compile_llvm_module(std::move(M), CPU, Features);
 }
 
 int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv);
-  std::unique_ptr<ir::module> M;
   try {
-    M = parseTritonIRFile(InputFilename);
+    std::string src = readFile(InputFilename);
+    std::unique_ptr<codegen::target> target = makeTarget();
+    std::vector<runtime::options_t> configs = enumerateConfigs();
+    std::string prefix = OutputFilename;
+    if (prefix.empty()) {
+      prefix = InputFilename;
+      size_t slash = prefix.rfind('/');
+      if (slash != std::string::npos)
+        prefix = prefix.substr(slash + 1);
+      prefix = prefix.substr(0, prefix.rfind('.'));
+    }
+    runtime::bundle_t bundle;
+    // kept for the argument names of the header
+    ir::context first_ctx;
+    std::unique_ptr<ir::module> first;
+    std::vector<std::string> objects;
+    for (size_t i = 0; i < configs.size(); i++) {
+      ir::context ctx;
+      std::unique_ptr<ir::module> M = parseTritonIR(src, i == 0 ? first_ctx : ctx, configs[i]);
+      ir::function* fn = M->get_function_list()[0];
+      std::vector<runtime::arg_type> sig;
+      for (size_t j = 0; j < fn->get_fn_type()->get_num_params(); j++)
+        sig.push_back(runtime::kernel::convert(fn->get_fn_type()->get_param_ty(j)));
+      if (i == 0) {
+        bundle.name = Name.empty() ? fn->get_name() : std::string(Name);
+        bundle.sig = sig;
+        for (size_t j = 0; j < sig.size(); j++)
+          bundle.arg_names.push_back(fn->args()[j]->get_name());
+      } else if (sig != bundle.sig) {
+        throw std::runtime_error("configuration " + configs[i].to_str() + " changes the kernel signature");
+      }
+      LLVMContext llvm_ctx;
+      std::unique_ptr<llvm::Module> llvm = runPasses(*M, target.get(), configs[i].num_warps, llvm_ctx);
+      if (i == 0)
+        first = std::move(M);
+      if (target->is_gpu()) {
+        llvm::outs() << "; " << configs[i].to_str() << "\n" << *llvm;
+        continue;
+      }
+      // the kernel itself is internal, so that configurations can be linked together
+      std::string entry = bundle.name + "_" + std::to_string(i);
+      driver::host_module::add_entry_point(*llvm, entry);
+      for (llvm::Function& f: llvm->functions())
+        if (!f.isDeclaration() && f.getName() != entry)
+          f.setLinkage(GlobalValue::InternalLinkage);
+      std::string obj = prefix + "." + std::to_string(i) + ".o";
+      writeFile(obj, driver::host_module::compile_llvm_module(std::move(llvm), CPU, Features));
+      objects.push_back(obj);
+      bundle.configs.push_back({entry, configs[i]});
+    }
+    if (target->is_gpu())
+      return 0;
+    objects.push_back(prefix + ".bundle.o");
+    writeFile(objects.back(), bundleObject(bundle));
+    writeFile(prefix + ".h", header(bundle, first->get_function_list()[0]));
+    if (Emit == "shared") {
+      std::string cc = tools::getenv("CC");
+      std::string cmd = (cc.empty() ? "cc" : cc) + " -shared -o " + prefix + ".so";
+      for (const std::string& obj: objects)
+        cmd += " " + obj;
+      cmd += " -lm";
+      if (std::system(cmd.c_str()) != 0)
+        throw std::runtime_error("linking failed: " + cmd);
+    } else if (Emit != "obj") {
+      throw std::runtime_error("unknown output kind " + Emit);
+    }
   } catch (const std::exception &e) {
-    std::cout << e.what();
+    std::cerr << e.what() << std::endl;
     return -1;
   }
-  print(*M, std::cout);
-  runPasses(*M);
-
   return 0;
-}
\ No newline at end of file
+}